@@ -0,0 +1,36 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemAcquireTargetAction.h"
+#include "TargetSystemComponent.h"
+
+UTargetSystemAcquireTargetAction* UTargetSystemAcquireTargetAction::AcquireTargetAsync(UTargetSystemComponent* TargetSystemComponent, const bool bLockOn)
+{
+	UTargetSystemAcquireTargetAction* Action = NewObject<UTargetSystemAcquireTargetAction>();
+	Action->TargetSystemComponent = TargetSystemComponent;
+	Action->bLockOn = bLockOn;
+	Action->RegisterWithGameInstance(TargetSystemComponent);
+	return Action;
+}
+
+void UTargetSystemAcquireTargetAction::Activate()
+{
+	const FTargetSystemAcquisitionComplete OnComplete = FTargetSystemAcquisitionComplete::CreateUObject(this, &UTargetSystemAcquireTargetAction::OnAcquisitionComplete);
+	if (!IsValid(TargetSystemComponent) || !TargetSystemComponent->TargetActorAsync(bLockOn, OnComplete))
+	{
+		OnAcquisitionComplete(nullptr);
+	}
+}
+
+void UTargetSystemAcquireTargetAction::OnAcquisitionComplete(AActor* Target)
+{
+	if (Target)
+	{
+		Acquired.Broadcast(Target);
+	}
+	else
+	{
+		NotFound.Broadcast(nullptr);
+	}
+
+	SetReadyToDestroy();
+}
@@ -0,0 +1,271 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemCandidateSnapshot.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/MemStack.h"
+
+static TAutoConsoleVariable<int32> CVarTargetSystemParallelCandidateThreshold(
+	TEXT("TargetSystem.ParallelCandidateThreshold"),
+	1024,
+	TEXT("Number of candidates from which the candidate filtering and scoring kernels run in parallel, over chunks of candidates.\n")
+	TEXT("Results are the same as with the serial path. 0 to always run serially."),
+	ECVF_Default
+);
+
+namespace TargetSystemCandidateSnapshot
+{
+	static constexpr int32 ChunkSize = 256;
+
+	static bool ShouldRunInParallel(const int32 Num)
+	{
+		const int32 Threshold = CVarTargetSystemParallelCandidateThreshold.GetValueOnAnyThread();
+		return Threshold > 0 && Num >= Threshold;
+	}
+
+	// Calls Function(StartIndex, EndIndex) over [0, Num), with ParallelFor over chunks of candidates above the threshold.
+	// Function must only write to the indices of its own range, for results not to depend on the scheduling.
+	template <typename FunctionType>
+	static void ForEachChunk(const int32 Num, FunctionType&& Function)
+	{
+		if (!ShouldRunInParallel(Num))
+		{
+			Function(0, Num);
+			return;
+		}
+
+		ParallelFor(FMath::DivideAndRoundUp(Num, ChunkSize), [&Function, Num](const int32 Chunk)
+		{
+			const int32 StartIndex = Chunk * ChunkSize;
+			Function(StartIndex, FMath::Min(StartIndex + ChunkSize, Num));
+		});
+	}
+}
+
+void FTargetSystemCandidateSnapshot::Reset(const int32 NewSize)
+{
+	Actors.Reset(NewSize);
+	AimPoints.Reset(NewSize);
+	BoundingRadii.Reset(NewSize);
+	Priorities.Reset(NewSize);
+	RelationBits.Reset(NewSize);
+	WidgetSockets.Reset(NewSize);
+	Targetable.Reset(NewSize);
+	LastRenderTimes.Reset(NewSize);
+	TagBits.Reset(NewSize);
+	RelativeAimPoints.Reset(NewSize);
+}
+
+void FTargetSystemCandidateSnapshot::Add(AActor* Actor, const FTargetSystemTargetingData& TargetingData, const bool bIsTargetable, const FTargetSystemTagBits& InTagBits, const float LastRenderTime)
+{
+	Actors.Add(Actor);
+	AimPoints.Add(TargetingData.AimPoint);
+	BoundingRadii.Add(TargetingData.BoundingRadius);
+	Priorities.Add(TargetingData.Priority);
+	RelationBits.Add(FTargetSystemTargetingData::MakeRelationBits(TargetingData.TeamBits, TargetingData.FactionBits));
+	WidgetSockets.Add(TargetingData.WidgetSocket);
+	Targetable.Add(bIsTargetable);
+	LastRenderTimes.Add(LastRenderTime);
+	TagBits.Add(InTagBits);
+}
+
+void FTargetSystemCandidateSnapshot::Append(const FTargetSystemCandidateSnapshot& Other)
+{
+	Actors.Append(Other.Actors);
+	AimPoints.Append(Other.AimPoints);
+	BoundingRadii.Append(Other.BoundingRadii);
+	Priorities.Append(Other.Priorities);
+	RelationBits.Append(Other.RelationBits);
+	WidgetSockets.Append(Other.WidgetSockets);
+	Targetable.Append(Other.Targetable);
+	LastRenderTimes.Append(Other.LastRenderTimes);
+	TagBits.Append(Other.TagBits);
+}
+
+void FTargetSystemCandidateSnapshot::Rebase(const FVector& NewOrigin)
+{
+	Origin = NewOrigin;
+
+	const int32 NumCandidates = Num();
+	RelativeAimPoints.SetNumUninitialized(NumCandidates);
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		// Subtract at double precision first, only the (small) difference is stored as float
+		RelativeAimPoints[Index] = FVector3f(AimPoints[Index] - Origin);
+	}
+}
+
+void FTargetSystemCandidateSnapshot::GetDistancesSquared(const FVector& Location, const TArrayView<const int32> Candidates, const TArrayView<float> OutDistancesSquared) const
+{
+	check(OutDistancesSquared.Num() == Candidates.Num());
+
+	const FVector3f RelativeLocation = ToRelative(Location);
+	const FVector3f* Points = RelativeAimPoints.GetData();
+	const int32* CandidateIndices = Candidates.GetData();
+	float* DistancesSquared = OutDistancesSquared.GetData();
+
+	TargetSystemCandidateSnapshot::ForEachChunk(Candidates.Num(), [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+		{
+			DistancesSquared[Index] = FVector3f::DistSquared(Points[CandidateIndices[Index]], RelativeLocation);
+		}
+	});
+}
+
+void FTargetSystemCandidateSnapshot::GetYawAngles(const FVector& ViewLocation, const float ViewYaw, const TArray<int32>& Candidates, TArray<float>& OutAngles) const
+{
+	const FVector3f RelativeViewLocation = ToRelative(ViewLocation);
+	const FVector3f* Points = RelativeAimPoints.GetData();
+	const int32* CandidateIndices = Candidates.GetData();
+
+	OutAngles.SetNumUninitialized(Candidates.Num());
+	float* Angles = OutAngles.GetData();
+
+	TargetSystemCandidateSnapshot::ForEachChunk(Candidates.Num(), [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+		{
+			const FVector3f Direction = Points[CandidateIndices[Index]] - RelativeViewLocation;
+			const float YawAngle = ViewYaw - FMath::RadiansToDegrees(FMath::Atan2(Direction.Y, Direction.X));
+			Angles[Index] = YawAngle < 0.0f ? YawAngle + 360.0f : YawAngle;
+		}
+	});
+}
+
+int32 FTargetSystemCandidateSnapshot::FindBest(const TArray<int32>& Candidates, const TArray<float>& Values, const float MaxValue) const
+{
+	check(Values.Num() == Candidates.Num());
+
+	// First best of [StartIndex, EndIndex), strict comparisons keeping the first one on ties
+	const auto FindFirstBest = [this, &Candidates, &Values, MaxValue](const int32 StartIndex, const int32 EndIndex)
+	{
+		int32 Best = INDEX_NONE;
+		for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+		{
+			if (Values[Index] < MaxValue && (Best == INDEX_NONE || IsBetter(Candidates[Index], Values[Index], Candidates[Best], Values[Best])))
+			{
+				Best = Index;
+			}
+		}
+
+		return Best;
+	};
+
+	const int32 NumValues = Values.Num();
+	if (!TargetSystemCandidateSnapshot::ShouldRunInParallel(NumValues))
+	{
+		return FindFirstBest(0, NumValues);
+	}
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumValues, TargetSystemCandidateSnapshot::ChunkSize);
+
+	FMemMark Mark(FMemStack::Get());
+	TArray<int32, TMemStackAllocator<>> ChunkBest;
+	ChunkBest.SetNumUninitialized(NumChunks);
+
+	ParallelFor(NumChunks, [&](const int32 Chunk)
+	{
+		const int32 StartIndex = Chunk * TargetSystemCandidateSnapshot::ChunkSize;
+		ChunkBest[Chunk] = FindFirstBest(StartIndex, FMath::Min(StartIndex + TargetSystemCandidateSnapshot::ChunkSize, NumValues));
+	});
+
+	// Reduce in chunk order, keeping the first chunk on ties, which is what the serial loop ends up with
+	int32 Best = INDEX_NONE;
+	for (const int32 ChunkIndex : ChunkBest)
+	{
+		if (ChunkIndex != INDEX_NONE && (Best == INDEX_NONE || IsBetter(Candidates[ChunkIndex], Values[ChunkIndex], Candidates[Best], Values[Best])))
+		{
+			Best = ChunkIndex;
+		}
+	}
+
+	return Best;
+}
+
+int32 FTargetSystemCandidateSnapshot::Filter(const FTargetSystemCandidateFilter& CandidateFilter, const TArrayView<int32> OutCandidates) const
+{
+	const int32 NumCandidates = Num();
+	check(OutCandidates.Num() >= NumCandidates);
+
+	const uint64* Relations = RelationBits.GetData();
+	const bool* Targetables = Targetable.GetData();
+	const float* RenderTimes = LastRenderTimes.GetData();
+	const bool bHasTagQuery = CandidateFilter.TagQuery && !CandidateFilter.TagQuery->IsEmpty();
+
+	// Tag queries that couldn't be compiled read the owned tags of the targets, only done while compacting
+	const bool bHasCompiledTagQuery = bHasTagQuery && CandidateFilter.TagQuery->IsCompiled();
+	const bool bHasUncompiledTagQuery = bHasTagQuery && !bHasCompiledTagQuery;
+
+	FMemMark Mark(FMemStack::Get());
+	TArray<uint8, TMemStackAllocator<>> Passed;
+	Passed.SetNumUninitialized(NumCandidates);
+	uint8* PassedData = Passed.GetData();
+
+	TargetSystemCandidateSnapshot::ForEachChunk(NumCandidates, [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		// Branchless pass over contiguous arrays, for the compiler to vectorize it: a single AND on the team / faction bits,
+		// targetability and last render time
+		for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+		{
+			PassedData[Index] = static_cast<uint8>((Relations[Index] & CandidateFilter.IgnoredRelationBits) == 0) & static_cast<uint8>(Targetables[Index])
+				& static_cast<uint8>(RenderTimes[Index] >= CandidateFilter.MinLastRenderTime);
+		}
+
+		for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+		{
+			if (!PassedData[Index])
+			{
+				continue;
+			}
+
+			if (bHasCompiledTagQuery && !CandidateFilter.TagQuery->Matches(TagBits[Index], Actors[Index]))
+			{
+				PassedData[Index] = 0;
+			}
+			else if (CandidateFilter.ActorClass && !Actors[Index]->IsA(CandidateFilter.ActorClass))
+			{
+				PassedData[Index] = 0;
+			}
+		}
+	});
+
+	// Compact serially, for candidates to stay in snapshot order
+	int32 NumPassed = 0;
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		if (PassedData[Index] && (!bHasUncompiledTagQuery || CandidateFilter.TagQuery->MatchesOwnedTags(Actors[Index])))
+		{
+			OutCandidates[NumPassed++] = Index;
+		}
+	}
+
+	return NumPassed;
+}
+
+bool FTargetSystemCandidateSnapshot::PassesFilter(const FTargetSystemCandidateFilter& CandidateFilter, const int32 Index) const
+{
+	if ((RelationBits[Index] & CandidateFilter.IgnoredRelationBits) != 0 || !Targetable[Index] || LastRenderTimes[Index] < CandidateFilter.MinLastRenderTime)
+	{
+		return false;
+	}
+
+	if (CandidateFilter.TagQuery && !CandidateFilter.TagQuery->IsEmpty() && !CandidateFilter.TagQuery->Matches(TagBits[Index], Actors[Index]))
+	{
+		return false;
+	}
+
+	return !CandidateFilter.ActorClass || Actors[Index]->IsA(CandidateFilter.ActorClass);
+}
+
+FTargetSystemTargetingData FTargetSystemCandidateSnapshot::GetTargetingData(const int32 Index) const
+{
+	FTargetSystemTargetingData TargetingData;
+	TargetingData.AimPoint = AimPoints[Index];
+	TargetingData.BoundingRadius = BoundingRadii[Index];
+	TargetingData.Priority = Priorities[Index];
+	TargetingData.TeamBits = static_cast<int32>(RelationBits[Index] & 0xFFFFFFFF);
+	TargetingData.FactionBits = static_cast<int32>(RelationBits[Index] >> 32);
+	TargetingData.WidgetSocket = WidgetSockets[Index];
+	return TargetingData;
+}
@@ -1,35 +1,242 @@
 // Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
 
 #include "TargetSystemComponent.h"
-#include "EngineUtils.h"
 #include "TargetSystemLog.h"
+#include "TargetSystemPreset.h"
+#include "TargetSystemStats.h"
+#include "TargetSystemSubsystem.h"
 #include "TargetSystemTargetableInterface.h"
-#include "TimerManager.h"
+#include "TargetSystemViewProjection.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/WidgetComponent.h"
+#include "Engine/AssetManager.h"
 #include "Engine/GameViewportClient.h"
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Pawn.h"
 #include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/MemStack.h"
+#include "Tasks/Task.h"
+#include "UObject/GarbageCollection.h"
 
 #include "Net/UnrealNetwork.h"
 
+namespace TargetSystemComponent
+{
+	// View of occlusion buffers without a player camera, AI for instance.
+	static constexpr float DefaultOcclusionFOV = 90.0f;
+	static constexpr float DefaultOcclusionAspectRatio = 16.0f / 9.0f;
+
+	// Sets OutSetting to the value of a deprecated property when it is not the default one.
+	template <typename ValueType, typename SettingType>
+	static void UpgradeDeprecated(const ValueType& Deprecated, const ValueType& DeprecatedDefault, SettingType& OutSetting, bool& bOutUpgraded)
+	{
+		if (!(Deprecated == DeprecatedDefault))
+		{
+			OutSetting = Deprecated;
+			bOutUpgraded = true;
+		}
+	}
+
+	// Fills OutSortedCandidates with the candidates of Snapshot passing Filter, in the viewport and closer than
+	// MaxDistanceSquared from Location, highest priority then nearest first. Safe to call from any thread.
+	static void SortCandidatesByDistance(const FTargetSystemCandidateSnapshot& Snapshot, const FTargetSystemCandidateFilter& Filter, const FTargetSystemViewProjection& ViewProjection, const FVector& Location, const float MaxDistanceSquared, TArray<int32>& OutSortedCandidates)
+	{
+		FMemMark Mark(FMemStack::Get());
+
+		// Every buffer on the memory stack, tasks and game thread queries each having their own
+		TArray<int32, TMemStackAllocator<>> Candidates;
+		Snapshot.Filter(Filter, Candidates);
+		Candidates.RemoveAll([&Snapshot, &ViewProjection](const int32 Candidate)
+		{
+			return !ViewProjection.IsInViewport(Snapshot.AimPoints[Candidate]);
+		});
+
+		TArray<float, TMemStackAllocator<>> DistancesSquared;
+		Snapshot.GetDistancesSquared(Location, Candidates, DistancesSquared);
+
+		TArray<int32, TMemStackAllocator<>> InRange;
+		for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+		{
+			if (DistancesSquared[Index] < MaxDistanceSquared)
+			{
+				InRange.Add(Index);
+			}
+		}
+
+		// Stable, for ties to resolve in snapshot order as FTargetSystemCandidateSnapshot::FindBest does
+		InRange.StableSort([&Snapshot, &Candidates, &DistancesSquared](const int32 A, const int32 B)
+		{
+			return Snapshot.IsBetter(Candidates[A], DistancesSquared[A], Candidates[B], DistancesSquared[B]);
+		});
+
+		OutSortedCandidates.Reset(InRange.Num());
+		for (const int32 Index : InRange)
+		{
+			OutSortedCandidates.Add(Candidates[Index]);
+		}
+	}
+}
+
+// Acquisition started by UTargetSystemComponent::TargetActorAsync(). Task inputs are copies taken on the game thread,
+// task outputs are only read on the game thread once bTaskCompleted is set.
+struct FTargetSystemAcquisition
+{
+	bool bLockOn = false;
+	FTargetSystemAcquisitionComplete OnComplete;
+
+	//~ Task inputs
+
+	FTargetSystemCandidateSnapshot Snapshot;
+	// Snapshot actors, for the task to skip the ones destroyed since the snapshot was taken
+	TArray<TWeakObjectPtr<AActor>> WeakActors;
+	FTargetSystemCompiledTagQuery TagQuery;
+	FTargetSystemCandidateFilter Filter;
+	FTargetSystemViewProjection ViewProjection;
+	FVector Location = FVector::ZeroVector;
+	float MaxDistanceSquared = 0.0f;
+
+	//~ Task outputs
+
+	// Candidates passing the filter, in the viewport and in range, nearest first
+	TArray<int32> SortedCandidates;
+	std::atomic<bool> bTaskCompleted { false };
+
+	//~ Traces, issued on the game thread once the task completed
+
+	enum class ETraceResult : uint8
+	{
+		Pending,
+		Visible,
+		Blocked
+	};
+
+	bool bTracesIssued = false;
+	// Start of the traces, for their results to be shared through the line of sight cache
+	FVector TraceStart = FVector::ZeroVector;
+
+	// Result of each of SortedCandidates, and number of its visibility point traces still in flight
+	TArray<ETraceResult> TraceResults;
+	TArray<int32> NumPendingTraces;
+
+	// Traces in flight, with the index in SortedCandidates and the visibility point each was issued for
+	TArray<FTraceHandle> TraceHandles;
+	TArray<int32> TraceCandidates;
+	TArray<int32> TracePoints;
+
+	// Runs off the game thread
+	void SortCandidates();
+
+	// Returns the nearest visible candidate, once every nearer one is known to be blocked
+	bool TryResolve(AActor*& OutTarget) const;
+};
+
+void FTargetSystemAcquisition::SortCandidates()
+{
+	// Garbage collection must not free candidates while the filter reads their class
+	FGCScopeGuard GCScopeGuard;
+
+	for (int32 Index = 0; Index < WeakActors.Num(); ++Index)
+	{
+		if (!WeakActors[Index].IsValid(true, true))
+		{
+			Snapshot.Targetable[Index] = false;
+		}
+	}
+
+	TargetSystemComponent::SortCandidatesByDistance(Snapshot, Filter, ViewProjection, Location, MaxDistanceSquared, SortedCandidates);
+}
+
+bool FTargetSystemAcquisition::TryResolve(AActor*& OutTarget) const
+{
+	OutTarget = nullptr;
+	for (int32 Index = 0; Index < TraceResults.Num(); ++Index)
+	{
+		if (TraceResults[Index] == ETraceResult::Pending)
+		{
+			return false;
+		}
+
+		if (TraceResults[Index] == ETraceResult::Visible)
+		{
+			OutTarget = WeakActors[SortedCandidates[Index]].Get();
+			return true;
+		}
+	}
+
+	return true;
+}
+
 // Sets default values for this component's properties
 UTargetSystemComponent::UTargetSystemComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 
-	LockedOnWidgetClass = StaticLoadClass(UObject::StaticClass(), nullptr, TEXT("/TargetSystem/UI/WBP_LockOn.WBP_LockOn_C"));
-	TargetableActors = APawn::StaticClass();
-	TargetableCollisionChannel = ECollisionChannel::ECC_Pawn;
+	TraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(TargetSystemLineTrace), false);
+	AcquisitionTraceDelegate.BindUObject(this, &UTargetSystemComponent::OnAcquisitionTraceDone);
+	AimAssistTraceDelegate.BindUObject(this, &UTargetSystemComponent::OnAimAssistTraceDone);
+
+#if WITH_EDITORONLY_DATA
+	TargetableActors_DEPRECATED = APawn::StaticClass();
+#endif
+}
+
+void UTargetSystemComponent::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Tuning values saved before presets only differ from the class defaults when they were edited. Those move to a
+	// PresetOverride based on the preset in use, for the component to keep behaving as it did.
+	const UTargetSystemComponent* Defaults = GetDefault<UTargetSystemComponent>();
+	FTargetSystemSettings Settings = GetSettings();
+	bool bUpgraded = false;
+
+	TargetSystemComponent::UpgradeDeprecated(MinimumDistanceToEnable_DEPRECATED, Defaults->MinimumDistanceToEnable_DEPRECATED, Settings.MinimumDistanceToEnable, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(TargetableActors_DEPRECATED, Defaults->TargetableActors_DEPRECATED, Settings.TargetableActors, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(TargetableCollisionChannel_DEPRECATED, Defaults->TargetableCollisionChannel_DEPRECATED, Settings.TargetableCollisionChannel, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(bShouldControlRotation_DEPRECATED, Defaults->bShouldControlRotation_DEPRECATED, Settings.bShouldControlRotation, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(bIgnoreLookInput_DEPRECATED, Defaults->bIgnoreLookInput_DEPRECATED, Settings.bIgnoreLookInput, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(BreakLineOfSightDelay_DEPRECATED, Defaults->BreakLineOfSightDelay_DEPRECATED, Settings.BreakLineOfSightDelay, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(RotationHalfLife_DEPRECATED, Defaults->RotationHalfLife_DEPRECATED, Settings.RotationHalfLife, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(StartRotatingThreshold_DEPRECATED, Defaults->StartRotatingThreshold_DEPRECATED, Settings.StartRotatingThreshold, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(bShouldDrawLockedOnWidget_DEPRECATED, Defaults->bShouldDrawLockedOnWidget_DEPRECATED, Settings.bShouldDrawLockedOnWidget, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(LockedOnWidgetDrawSize_DEPRECATED, Defaults->LockedOnWidgetDrawSize_DEPRECATED, Settings.LockedOnWidgetDrawSize, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(LockedOnWidgetParentSocket_DEPRECATED, Defaults->LockedOnWidgetParentSocket_DEPRECATED, Settings.LockedOnWidgetParentSocket, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(LockedOnWidgetRelativeLocation_DEPRECATED, Defaults->LockedOnWidgetRelativeLocation_DEPRECATED, Settings.LockedOnWidgetRelativeLocation, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(bAdjustPitchBasedOnDistanceToTarget_DEPRECATED, Defaults->bAdjustPitchBasedOnDistanceToTarget_DEPRECATED, Settings.bAdjustPitchBasedOnDistanceToTarget, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(PitchDistanceCoefficient_DEPRECATED, Defaults->PitchDistanceCoefficient_DEPRECATED, Settings.PitchDistanceCoefficient, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(PitchDistanceOffset_DEPRECATED, Defaults->PitchDistanceOffset_DEPRECATED, Settings.PitchDistanceOffset, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(PitchMin_DEPRECATED, Defaults->PitchMin_DEPRECATED, Settings.PitchMin, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(PitchMax_DEPRECATED, Defaults->PitchMax_DEPRECATED, Settings.PitchMax, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(IgnoredTeamMask_DEPRECATED, Defaults->IgnoredTeamMask_DEPRECATED, Settings.IgnoredTeamMask, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(IgnoredFactionMask_DEPRECATED, Defaults->IgnoredFactionMask_DEPRECATED, Settings.IgnoredFactionMask, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(TargetTagQuery_DEPRECATED, Defaults->TargetTagQuery_DEPRECATED, Settings.TargetTagQuery, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(bEnableStickyTarget_DEPRECATED, Defaults->bEnableStickyTarget_DEPRECATED, Settings.bEnableStickyTarget, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(AxisMultiplier_DEPRECATED, Defaults->AxisMultiplier_DEPRECATED, Settings.AxisMultiplier, bUpgraded);
+	TargetSystemComponent::UpgradeDeprecated(StickyRotationThreshold_DEPRECATED, Defaults->StickyRotationThreshold_DEPRECATED, Settings.StickyRotationThreshold, bUpgraded);
+
+	// Previously loaded with the component, now a soft reference
+	if (LockedOnWidgetClass_DEPRECATED)
+	{
+		Settings.LockedOnWidgetClass = TSoftClassPtr<UUserWidget>(LockedOnWidgetClass_DEPRECATED.Get());
+		bUpgraded = true;
+	}
+
+	if (bUpgraded)
+	{
+		GetOrCreatePresetOverride().Settings = Settings;
+		TS_LOG(Display, TEXT("UTargetSystemComponent::PostLoad - %s: Moved tuning values saved with the component to its PresetOverride, resave to keep them"), *GetPathName());
+	}
+#endif
 }
 
 void UTargetSystemComponent::GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const
 {
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
-	DOREPLIFETIME(UTargetSystemComponent, LockedOnTargetActor);
-	DOREPLIFETIME(UTargetSystemComponent, bTargetLocked);
+	DOREPLIFETIME(UTargetSystemComponent, LockOnState);
 }
 
 // Called when the game starts
@@ -51,225 +258,881 @@ void UTargetSystemComponent::BeginPlay()
 	}
 
 	SetupLocalPlayerController();
+
+	TargetSystemSubsystem = UWorld::GetSubsystem<UTargetSystemSubsystem>(GetWorld());
+	RegisterSettings();
+
+	CompileTargetTagQuery();
+
+	TargetabilityChangedHandle = ITargetSystemTargetableInterface::OnTargetabilityChanged().AddUObject(this, &UTargetSystemComponent::OnTargetabilityChanged);
+}
+
+void UTargetSystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ITargetSystemTargetableInterface::OnTargetabilityChanged().Remove(TargetabilityChangedHandle);
+	UnbindLockedOnTargetEvents(LockOnState.Target.Get());
+
+	// Traces still in flight are ignored once PendingAcquisition is reset, the task releases its own reference
+	if (PendingAcquisition)
+	{
+		CompleteAcquisition(nullptr);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UTargetSystemComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (!bTargetLocked || !LockedOnTargetActor)
+	UpdateAcquisition();
+	UpdateBestCandidate();
+	UpdateAimAssist(DeltaTime);
+
+	// Targetability changes and target removal are pushed to us (see OnTargetabilityChanged and
+	// OnLockedOnTargetEndPlay), no need to poll the target here
+	AActor* LockedOnTargetActor = LockOnState.Target.Get();
+	const bool bLocked = LockOnState.bTargetLocked && LockedOnTargetActor;
+
+	// Gather the world state the lock on simulation needs for this step
+	FTargetSystemLockOnInput Input;
+	if (bLocked)
+	{
+		FTargetSystemTargetingData TargetingData;
+		GetTargetingData(LockedOnTargetActor, TargetingData);
+
+		if (IsValid(OwnerPlayerController))
+		{
+			Input.ControlRotation = OwnerPlayerController->GetControlRotation();
+			Input.DesiredRotation = GetDesiredControlRotationOnTarget(TargetingData.AimPoint);
+			Input.bHasDesiredRotation = true;
+		}
+
+		Input.DistanceToTarget = GetDistanceFromCharacter(TargetingData.AimPoint);
+		Input.bLineOfSightBlocked = ShouldBreakLineOfSight(TargetingData.AimPoint);
+		Input.bHasTargetState = true;
+	}
+
+	const FTargetSystemLockOnOutput Output = LockOnState.Step(GetLockOnParams(), Input, DeltaTime);
+	if (!bLocked)
 	{
 		return;
 	}
 
-	if (!TargetIsTargetable(LockedOnTargetActor))
+	if (Output.bHasControlRotation)
+	{
+		SetControlRotationOnTarget(LockedOnTargetActor, Output.ControlRotation);
+	}
+
+	if (Output.bShouldLockOff)
 	{
 		TargetLockOff();
-		return;
 	}
+}
 
-	SetControlRotationOnTarget(LockedOnTargetActor);
+void UTargetSystemComponent::TargetActor()
+{
+	ClosestTargetDistance = GetSettings().MinimumDistanceToEnable;
 
-	// Target Locked Off based on Distance
-	if (GetDistanceFromCharacter(LockedOnTargetActor) > MinimumDistanceToEnable)
+	if (LockOnState.bTargetLocked)
 	{
 		TargetLockOff();
 	}
+	else
+	{
+		// Commit the candidate maintained in the background right away, only paying for a single validation trace
+		AActor* Target = GetValidatedBestCandidate();
+		if (!Target)
+		{
+			if (const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot())
+			{
+				FTargetSystemQueryScratchScope ScratchScope(QueryScratch);
+				Snapshot->Filter(GetCandidateFilter(), QueryScratch.Candidates);
+				RemoveOccludedCandidates(*Snapshot, QueryScratch.Candidates);
+				Target = FindNearestTarget(*Snapshot, QueryScratch.Candidates);
+			}
+		}
+
+		LockOnState.Target = Target;
+		TargetLockOn(Target);
+	}
+}
+
+bool UTargetSystemComponent::TargetActorAsync(const bool bLockOn, FTargetSystemAcquisitionComplete OnComplete)
+{
+	const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot();
+	if (!Snapshot || !IsValid(OwnerActor))
+	{
+		return false;
+	}
+
+	if (PendingAcquisition)
+	{
+		CompleteAcquisition(nullptr);
+	}
+
+	// Copy everything the task reads, the snapshot and the compiled tag query being updated on the game thread
+	const TSharedRef<FTargetSystemAcquisition> Acquisition = MakeShared<FTargetSystemAcquisition>();
+	Acquisition->bLockOn = bLockOn;
+	Acquisition->OnComplete = MoveTemp(OnComplete);
+	Acquisition->Snapshot = *Snapshot;
+	Acquisition->WeakActors.Reserve(Snapshot->Num());
+	for (AActor* Actor : Snapshot->Actors)
+	{
+		Acquisition->WeakActors.Add(Actor);
+	}
+
+	// Tag queries that couldn't be compiled read the owned tags of the targets, which the task can't do
+	Acquisition->TagQuery = CompiledTargetTagQuery;
+	if (!CompiledTargetTagQuery.IsCompiled())
+	{
+		for (int32 Index = 0; Index < Snapshot->Num(); ++Index)
+		{
+			if (Acquisition->Snapshot.Targetable[Index] && !CompiledTargetTagQuery.MatchesOwnedTags(Snapshot->Actors[Index]))
+			{
+				Acquisition->Snapshot.Targetable[Index] = false;
+			}
+		}
+
+		Acquisition->TagQuery = FTargetSystemCompiledTagQuery();
+	}
+
+	Acquisition->Filter = GetCandidateFilter();
+	Acquisition->Filter.TagQuery = &Acquisition->TagQuery;
+	Acquisition->Location = OwnerActor->GetActorLocation();
+	Acquisition->MaxDistanceSquared = FMath::Square(GetSettings().MinimumDistanceToEnable);
+
+	SetupLocalPlayerController();
+	if (IsValid(OwnerPlayerController))
+	{
+		Acquisition->ViewProjection.Capture(OwnerPlayerController);
+	}
+
+	PendingAcquisition = Acquisition;
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [Acquisition]()
+	{
+		Acquisition->SortCandidates();
+		Acquisition->bTaskCompleted = true;
+	});
+
+	return true;
+}
+
+bool UTargetSystemComponent::IsAcquiringTarget() const
+{
+	return PendingAcquisition.IsValid();
+}
+
+void UTargetSystemComponent::UpdateAcquisition()
+{
+	if (!PendingAcquisition || PendingAcquisition->bTracesIssued || !PendingAcquisition->bTaskCompleted)
+	{
+		return;
+	}
+
+	FTargetSystemAcquisition& Acquisition = *PendingAcquisition;
+	Acquisition.bTracesIssued = true;
+
+	// Game thread only, occluders may move
+	RemoveOccludedCandidates(Acquisition.Snapshot, Acquisition.SortedCandidates);
+
+	UWorld* World = GetWorld();
+	if (Acquisition.SortedCandidates.Num() == 0 || !IsValid(OwnerActor) || !World)
+	{
+		CompleteAcquisition(nullptr);
+		return;
+	}
+
+	// Async traces copy the params, the cached ones can be reused right away
+	TraceParams.ClearIgnoredActors();
+	TraceParams.AddIgnoredActor(OwnerActor);
+
+	const FVector Start = OwnerActor->GetActorLocation();
+	const ECollisionChannel TraceChannel = GetSettings().TargetableCollisionChannel;
+	Acquisition.TraceStart = Start;
+	Acquisition.TraceResults.Init(FTargetSystemAcquisition::ETraceResult::Pending, Acquisition.SortedCandidates.Num());
+	Acquisition.NumPendingTraces.Init(0, Acquisition.SortedCandidates.Num());
+
+	TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>> Points;
+	for (int32 Index = 0; Index < Acquisition.SortedCandidates.Num(); ++Index)
+	{
+		const int32 Candidate = Acquisition.SortedCandidates[Index];
+		const AActor* CandidateActor = Acquisition.WeakActors[Candidate].Get();
+
+		// Same results as TargetActor(): known line of sight this frame first, then every visibility point
+		bool bVisible = false;
+		if (!CandidateActor || (TargetSystemSubsystem && TargetSystemSubsystem->FindCachedLineOfSight(Start, CandidateActor, nullptr, TraceChannel, VisibilityPointSet, bVisible)))
+		{
+			Acquisition.TraceResults[Index] = bVisible ? FTargetSystemAcquisition::ETraceResult::Visible : FTargetSystemAcquisition::ETraceResult::Blocked;
+			continue;
+		}
+
+		GetVisibilityPoints(CandidateActor, Acquisition.Snapshot.AimPoints[Candidate], Points);
+		for (const FTargetSystemVisibilityPoint& Point : Points)
+		{
+			// Points behind an occluder proxy are blocked without issuing their trace
+			if (TargetSystemSubsystem && TargetSystemSubsystem->IsOccluded(Start, Point.Location))
+			{
+				continue;
+			}
+
+			const bool bStaticallyClear = TargetSystemSubsystem && TargetSystemSubsystem->IsStaticallyClear(Start, Point.Location, TraceChannel);
+			TraceParams.MobilityType = bStaticallyClear ? EQueryMobilityType::Dynamic : EQueryMobilityType::Any;
+
+			Acquisition.TraceHandles.Add(World->AsyncLineTraceByChannel(
+				EAsyncTraceType::Single,
+				Start,
+				Point.Location,
+				TraceChannel,
+				TraceParams,
+				FCollisionResponseParams::DefaultResponseParam,
+				&AcquisitionTraceDelegate
+			));
+			Acquisition.TraceCandidates.Add(Index);
+			Acquisition.TracePoints.Add(Point.Index);
+			++Acquisition.NumPendingTraces[Index];
+		}
+
+		if (Acquisition.NumPendingTraces[Index] == 0)
+		{
+			Acquisition.TraceResults[Index] = FTargetSystemAcquisition::ETraceResult::Blocked;
+			if (TargetSystemSubsystem)
+			{
+				TargetSystemSubsystem->AddCachedLineOfSight(Start, CandidateActor, nullptr, TraceChannel, VisibilityPointSet, false);
+			}
+		}
+	}
+
+	// Completes right away when every candidate was cached or occluded
+	AActor* Target;
+	if (Acquisition.TryResolve(Target))
+	{
+		CompleteAcquisition(Target);
+	}
+}
+
+void UTargetSystemComponent::OnAcquisitionTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (!PendingAcquisition)
+	{
+		return;
+	}
+
+	// Traces of a completed or replaced acquisition are not found here
+	FTargetSystemAcquisition& Acquisition = *PendingAcquisition;
+	const int32 Index = Acquisition.TraceHandles.IndexOfByKey(TraceHandle);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Early out, the candidate is already known visible from another point
+	const int32 CandidateIndex = Acquisition.TraceCandidates[Index];
+	if (Acquisition.TraceResults[CandidateIndex] != FTargetSystemAcquisition::ETraceResult::Pending)
+	{
+		return;
+	}
+
+	const AActor* Candidate = Acquisition.WeakActors[Acquisition.SortedCandidates[CandidateIndex]].Get();
+	const bool bVisible = Candidate && TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].GetActor() == Candidate;
+	if (Candidate && TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->ReportVisibilityPoint(Candidate, VisibilityPointSet, Acquisition.TracePoints[Index], bVisible);
+	}
+
+	--Acquisition.NumPendingTraces[CandidateIndex];
+	if (!bVisible && Acquisition.NumPendingTraces[CandidateIndex] > 0)
+	{
+		return;
+	}
+
+	Acquisition.TraceResults[CandidateIndex] = bVisible ? FTargetSystemAcquisition::ETraceResult::Visible : FTargetSystemAcquisition::ETraceResult::Blocked;
+	if (Candidate && TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->AddCachedLineOfSight(Acquisition.TraceStart, Candidate, nullptr, GetSettings().TargetableCollisionChannel, VisibilityPointSet, bVisible);
+	}
+
+	AActor* Target;
+	if (Acquisition.TryResolve(Target))
+	{
+		CompleteAcquisition(Target);
+	}
+}
+
+void UTargetSystemComponent::CompleteAcquisition(AActor* Target)
+{
+	// Reset first, OnComplete may start another acquisition
+	const TSharedPtr<FTargetSystemAcquisition> Acquisition = MoveTemp(PendingAcquisition);
 
-	if (ShouldBreakLineOfSight() && !bIsBreakingLineOfSight)
+	if (Target && Acquisition->bLockOn && Target != LockOnState.Target.Get())
 	{
-		if (BreakLineOfSightDelay <= 0)
+		if (LockOnState.bTargetLocked)
 		{
 			TargetLockOff();
 		}
-		else
+
+		LockOnState.Target = Target;
+		TargetLockOn(Target);
+	}
+
+	Acquisition->OnComplete.ExecuteIfBound(Target);
+}
+
+AActor* UTargetSystemComponent::GetBestCandidate() const
+{
+	return BestCandidate.Get();
+}
+
+void UTargetSystemComponent::UpdateBestCandidate()
+{
+	const FTargetSystemSettings& Settings = GetSettings();
+	if (!Settings.bMaintainBestCandidate || LockOnState.bTargetLocked)
+	{
+		BestCandidateScanIndex = INDEX_NONE;
+		SetBestCandidate(nullptr);
+		return;
+	}
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	if (BestCandidateScanIndex == INDEX_NONE && CurrentTime >= NextBestCandidateScanTime)
+	{
+		NextBestCandidateScanTime = CurrentTime + Settings.BestCandidateScanInterval;
+		StartBestCandidateScan();
+	}
+
+	if (BestCandidateScanIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Nearest candidates are traced first, the scan ends with the first visible one
+	int32 NumTraces = 0;
+	while (BestCandidateScanIndex < BestCandidateScan.Num() && NumTraces < Settings.BestCandidateTracesPerFrame)
+	{
+		AActor* Candidate = BestCandidateScan[BestCandidateScanIndex++].Get();
+		if (!Candidate)
 		{
-			bIsBreakingLineOfSight = true;
-			GetWorld()->GetTimerManager().SetTimer(
-				LineOfSightBreakTimerHandle,
-				this,
-				&UTargetSystemComponent::BreakLineOfSight,
-				BreakLineOfSightDelay
-			);
+			continue;
+		}
+
+		FTargetSystemTargetingData TargetingData;
+		GetTargetingData(Candidate, TargetingData);
+
+		++NumTraces;
+		if (LineTraceForActor(Candidate, TargetingData.AimPoint))
+		{
+			BestCandidateScanIndex = INDEX_NONE;
+			SetBestCandidate(Candidate);
+			return;
 		}
 	}
+
+	if (BestCandidateScanIndex >= BestCandidateScan.Num())
+	{
+		BestCandidateScanIndex = INDEX_NONE;
+		SetBestCandidate(nullptr);
+	}
 }
 
-void UTargetSystemComponent::TargetActor()
+void UTargetSystemComponent::StartBestCandidateScan()
 {
-	ClosestTargetDistance = MinimumDistanceToEnable;
+	BestCandidateScan.Reset();
 
-	if (bTargetLocked)
+	const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot();
+	if (!Snapshot || !IsValid(OwnerActor))
 	{
-		TargetLockOff();
+		return;
 	}
-	else
+
+	FTargetSystemViewProjection ViewProjection;
+	if (IsValid(OwnerPlayerController))
 	{
-		const TArray<AActor*> Actors = GetAllActorsOfClass(TargetableActors);
-		LockedOnTargetActor = FindNearestTarget(Actors);
-		TargetLockOn(LockedOnTargetActor);
+		ViewProjection.Capture(OwnerPlayerController);
 	}
+
+	// Sorting is cheap, only traces need to be spread over frames
+	FTargetSystemQueryScratchScope ScratchScope(QueryScratch);
+	const float MaxDistanceSquared = FMath::Square(GetSettings().MinimumDistanceToEnable);
+	TargetSystemComponent::SortCandidatesByDistance(*Snapshot, GetCandidateFilter(), ViewProjection, OwnerActor->GetActorLocation(), MaxDistanceSquared, QueryScratch.Candidates);
+	RemoveOccludedCandidates(*Snapshot, QueryScratch.Candidates);
+
+	for (const int32 Candidate : QueryScratch.Candidates)
+	{
+		BestCandidateScan.Add(Snapshot->Actors[Candidate]);
+	}
+
+	BestCandidateScanIndex = 0;
 }
 
-void UTargetSystemComponent::TargetActorWithAxisInput(const float AxisValue)
+void UTargetSystemComponent::SetBestCandidate(AActor* Candidate)
 {
-	// If we're not locked on, do nothing
-	if (!bTargetLocked)
+	if (BestCandidate.Get() == Candidate)
 	{
 		return;
 	}
 
-	if (!LockedOnTargetActor)
+	BestCandidate = Candidate;
+	OnBestCandidateChanged.Broadcast(Candidate);
+}
+
+AActor* UTargetSystemComponent::GetValidatedBestCandidate() const
+{
+	AActor* Candidate = BestCandidate.Get();
+	if (!Candidate || !GetSettings().bMaintainBestCandidate || !TargetSystemSubsystem)
+	{
+		return nullptr;
+	}
+
+	// Same filters as a full query, candidates out of the gathered snapshot being out of range anyway
+	const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot();
+	const int32 Index = Snapshot ? Snapshot->Actors.Find(Candidate) : INDEX_NONE;
+	if (Index == INDEX_NONE || !Snapshot->PassesFilter(GetCandidateFilter(), Index))
+	{
+		return nullptr;
+	}
+
+	const FVector& AimPoint = Snapshot->AimPoints[Index];
+	const bool bInRange = GetDistanceFromCharacter(AimPoint) < GetSettings().MinimumDistanceToEnable;
+	if (!bInRange || !IsInViewport(AimPoint))
+	{
+		return nullptr;
+	}
+
+	return LineTraceForActor(Candidate, AimPoint) ? Candidate : nullptr;
+}
+
+AActor* UTargetSystemComponent::GetAimAssistTarget() const
+{
+	return AimAssistTarget.Get();
+}
+
+float UTargetSystemComponent::GetAimAssistInputScale() const
+{
+	return 1.0f - GetSettings().AimAssistSlowdown * AimAssistStrength;
+}
+
+void UTargetSystemComponent::UpdateAimAssist(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TargetSystemAimAssist);
+
+	const FTargetSystemSettings& Settings = GetSettings();
+	AimAssistTarget = nullptr;
+	AimAssistStrength = 0.0f;
+
+	if (!Settings.bEnableAimAssist || LockOnState.bTargetLocked || !IsValid(OwnerPlayerController) || !OwnerPlayerController->IsLocalController())
+	{
+		ResetAimAssistLineOfSight();
+		return;
+	}
+
+	const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot();
+	FTargetSystemViewProjection ViewProjection;
+	ViewProjection.Capture(OwnerPlayerController);
+	if (!Snapshot || !ViewProjection.bIsValid)
+	{
+		return;
+	}
+
+	// Forget about candidates not scored for a while
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	for (auto It = AimAssistLineOfSight.CreateIterator(); It; ++It)
+	{
+		if (CurrentTime - FMath::Max(It->Value.Time, It->Value.RequestTime) > Settings.AimAssistLineOfSightInterval * 4.0f)
+		{
+			CancelAimAssistTraces(It->Key);
+			It.RemoveCurrent();
+		}
+	}
+
+	FTargetSystemQueryScratchScope ScratchScope(QueryScratch);
+	TArray<int32>& Candidates = QueryScratch.Candidates;
+	Snapshot->Filter(GetCandidateFilter(), Candidates);
+	Snapshot->GetDistancesSquared(OwnerActor->GetActorLocation(), Candidates, QueryScratch.DistancesSquared);
+	ViewProjection.ProjectCandidates(*Snapshot, Candidates, QueryScratch.ScreenLocations);
+
+	// Score candidates in range by their distance to the crosshair, the center of this player view in split screen.
+	// Out of range candidates never get picked.
+	const FVector2f Crosshair(FVector2D(ViewProjection.ViewRect.Min + ViewProjection.ViewRect.Max) * 0.5);
+	const float RadiusInPixels = Settings.AimAssistRadius * ViewProjection.ViewRect.Height();
+	const float MaxDistanceSquared = FMath::Square(Settings.MinimumDistanceToEnable);
+
+	TArray<float>& ScreenDistances = QueryScratch.ScreenDistances;
+	ScreenDistances.SetNumUninitialized(Candidates.Num());
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		const bool bInRange = QueryScratch.DistancesSquared[Index] < MaxDistanceSquared;
+		ScreenDistances[Index] = bInRange ? FVector2f::Distance(QueryScratch.ScreenLocations[Index], Crosshair) : MAX_flt;
+	}
+
+	// Highest priority and nearest to the crosshair first, only tracing candidates whose line of sight result is outdated
+	int32 TraceBudget = Settings.AimAssistTracesPerFrame;
+	int32 Assisted = INDEX_NONE;
+	while (true)
+	{
+		const int32 Closest = Snapshot->FindBest(Candidates, ScreenDistances, RadiusInPixels);
+		if (Closest == INDEX_NONE)
+		{
+			break;
+		}
+
+		const int32 Candidate = Candidates[Closest];
+		if (HasAimAssistLineOfSight(Snapshot->Actors[Candidate], Snapshot->AimPoints[Candidate], CurrentTime, TraceBudget))
+		{
+			Assisted = Closest;
+			break;
+		}
+
+		ScreenDistances[Closest] = MAX_flt;
+	}
+
+	if (Assisted == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 Candidate = Candidates[Assisted];
+	AimAssistTarget = Snapshot->Actors[Candidate];
+	AimAssistStrength = RadiusInPixels > 0.0f ? 1.0f - ScreenDistances[Assisted] / RadiusInPixels : 0.0f;
+
+	// Bounded magnetism: the control rotation is pulled towards the target, never snapped to it
+	const float MaxStep = Settings.AimAssistMagnetism * AimAssistStrength * DeltaTime;
+	if (MaxStep <= 0.0f)
 	{
 		return;
 	}
 
-	// If we're not allowed to switch target, do nothing
-	if (!ShouldSwitchTargetActor(AxisValue))
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	OwnerPlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const FRotator ControlRotation = OwnerPlayerController->GetControlRotation();
+	const FRotator Delta = (FindLookAtRotation(ViewLocation, Snapshot->AimPoints[Candidate]) - ControlRotation).GetNormalized();
+
+	FRotator NewControlRotation = ControlRotation;
+	NewControlRotation.Yaw += FMath::Clamp(Delta.Yaw, -MaxStep, MaxStep);
+	NewControlRotation.Pitch += FMath::Clamp(Delta.Pitch, -MaxStep, MaxStep);
+	OwnerPlayerController->SetControlRotation(NewControlRotation);
+}
+
+bool UTargetSystemComponent::HasAimAssistLineOfSight(AActor* Candidate, const FVector& AimPoint, const double CurrentTime, int32& InOutTraceBudget)
+{
+	FAimAssistLineOfSight& LineOfSight = AimAssistLineOfSight.FindOrAdd(Candidate);
+	const float Interval = GetSettings().AimAssistLineOfSightInterval;
+	const bool bIsRecent = LineOfSight.bIsKnown && CurrentTime - LineOfSight.Time < Interval;
+
+	// Traces normally come back the next frame, requested again when lost (world changes, ...)
+	const bool bIsPending = LineOfSight.NumPendingTraces > 0 && CurrentTime - LineOfSight.RequestTime <= FMath::Max(Interval, UE_KINDA_SMALL_NUMBER);
+	if (!bIsRecent && !bIsPending && InOutTraceBudget > 0)
+	{
+		--InOutTraceBudget;
+		RequestAimAssistLineOfSight(Candidate, AimPoint, CurrentTime, LineOfSight);
+	}
+
+	// Until the traces come back, an outdated result is still better than none
+	return LineOfSight.bIsKnown && LineOfSight.bIsVisible;
+}
+
+void UTargetSystemComponent::RequestAimAssistLineOfSight(AActor* Candidate, const FVector& AimPoint, const double CurrentTime, FAimAssistLineOfSight& LineOfSight)
+{
+	UWorld* World = GetWorld();
+	if (!IsValid(OwnerActor) || !World)
 	{
 		return;
 	}
 
-	// If we're switching target, do nothing for a set amount of time
-	if (bIsSwitchingTarget)
+	const TObjectKey<AActor> CandidateKey(Candidate);
+	CancelAimAssistTraces(CandidateKey);
+	LineOfSight.NumPendingTraces = 0;
+	LineOfSight.RequestTime = CurrentTime;
+
+	// Known line of sight this frame first, from the best candidate scan, acquisitions or other components
+	const FVector Start = OwnerActor->GetActorLocation();
+	const ECollisionChannel TraceChannel = GetSettings().TargetableCollisionChannel;
+	bool bVisible = false;
+	if (TargetSystemSubsystem && TargetSystemSubsystem->FindCachedLineOfSight(Start, Candidate, nullptr, TraceChannel, VisibilityPointSet, bVisible))
+	{
+		LineOfSight.bIsVisible = bVisible;
+		LineOfSight.bIsKnown = true;
+		LineOfSight.Time = CurrentTime;
+		return;
+	}
+
+	// Async traces copy the params, the cached ones can be reused right away
+	TraceParams.ClearIgnoredActors();
+	TraceParams.AddIgnoredActor(OwnerActor);
+
+	TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>> Points;
+	GetVisibilityPoints(Candidate, AimPoint, Points);
+	for (const FTargetSystemVisibilityPoint& Point : Points)
+	{
+		// Points behind an occluder proxy are blocked without issuing their trace
+		if (TargetSystemSubsystem && TargetSystemSubsystem->IsOccluded(Start, Point.Location))
+		{
+			continue;
+		}
+
+		const bool bStaticallyClear = TargetSystemSubsystem && TargetSystemSubsystem->IsStaticallyClear(Start, Point.Location, TraceChannel);
+		TraceParams.MobilityType = bStaticallyClear ? EQueryMobilityType::Dynamic : EQueryMobilityType::Any;
+
+		INC_DWORD_STAT(STAT_TargetSystemAimAssistTraces);
+		AimAssistTraceHandles.Add(World->AsyncLineTraceByChannel(
+			EAsyncTraceType::Single,
+			Start,
+			Point.Location,
+			TraceChannel,
+			TraceParams,
+			FCollisionResponseParams::DefaultResponseParam,
+			&AimAssistTraceDelegate
+		));
+		AimAssistTraceCandidates.Add(CandidateKey);
+		AimAssistTracePoints.Add(Point.Index);
+		++LineOfSight.NumPendingTraces;
+	}
+
+	LineOfSight.TraceStart = Start;
+	if (LineOfSight.NumPendingTraces == 0)
+	{
+		LineOfSight.bIsVisible = false;
+		LineOfSight.bIsKnown = true;
+		LineOfSight.Time = CurrentTime;
+		if (TargetSystemSubsystem)
+		{
+			TargetSystemSubsystem->AddCachedLineOfSight(Start, Candidate, nullptr, TraceChannel, VisibilityPointSet, false);
+		}
+	}
+}
+
+void UTargetSystemComponent::CancelAimAssistTraces(const TObjectKey<AActor>& Candidate)
+{
+	for (int32 Index = AimAssistTraceCandidates.Num() - 1; Index >= 0; --Index)
+	{
+		if (AimAssistTraceCandidates[Index] == Candidate)
+		{
+			AimAssistTraceHandles.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			AimAssistTraceCandidates.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			AimAssistTracePoints.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UTargetSystemComponent::OnAimAssistTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	// Traces of cancelled requests are not found here
+	const int32 Index = AimAssistTraceHandles.IndexOfByKey(TraceHandle);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	const TObjectKey<AActor> CandidateKey = AimAssistTraceCandidates[Index];
+	const int32 PointIndex = AimAssistTracePoints[Index];
+	AimAssistTraceHandles.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	AimAssistTraceCandidates.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	AimAssistTracePoints.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	FAimAssistLineOfSight* LineOfSight = AimAssistLineOfSight.Find(CandidateKey);
+	const AActor* Candidate = CandidateKey.ResolveObjectPtr();
+	if (!LineOfSight || !Candidate || !GetWorld())
+	{
+		CancelAimAssistTraces(CandidateKey);
+		return;
+	}
+
+	const bool bVisible = TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].GetActor() == Candidate;
+	if (TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->ReportVisibilityPoint(Candidate, VisibilityPointSet, PointIndex, bVisible);
+	}
+
+	// Early out on the first visible point, the others of the request are ignored
+	--LineOfSight->NumPendingTraces;
+	if (!bVisible && LineOfSight->NumPendingTraces > 0)
+	{
+		return;
+	}
+
+	CancelAimAssistTraces(CandidateKey);
+	LineOfSight->NumPendingTraces = 0;
+	LineOfSight->bIsVisible = bVisible;
+	LineOfSight->bIsKnown = true;
+	LineOfSight->Time = GetWorld()->GetTimeSeconds();
+
+	if (TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->AddCachedLineOfSight(LineOfSight->TraceStart, Candidate, nullptr, GetSettings().TargetableCollisionChannel, VisibilityPointSet, bVisible);
+	}
+}
+
+void UTargetSystemComponent::ResetAimAssistLineOfSight()
+{
+	AimAssistLineOfSight.Reset();
+	AimAssistTraceHandles.Reset();
+	AimAssistTraceCandidates.Reset();
+	AimAssistTracePoints.Reset();
+}
+
+void UTargetSystemComponent::TargetActorWithAxisInput(const float AxisValue)
+{
+	const FTargetSystemSettings& Settings = GetSettings();
+
+	// Feed the axis value to the lock on simulation, which does nothing if we're not locked on, not allowed to switch
+	// target, or still switching target
+	FTargetSystemLockOnInput Input;
+	Input.SwitchAxisValue = AxisValue;
+	Input.bHasSwitchAxisInput = true;
+
+	const FTargetSystemLockOnOutput Output = LockOnState.Step(GetLockOnParams(), Input, 0.0f);
+	if (!Output.bShouldSwitchTarget)
+	{
+		return;
+	}
+
+	const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot();
+	if (!Snapshot)
 	{
 		return;
 	}
 
 	// Lock off target
-	AActor* CurrentTarget = LockedOnTargetActor;
+	AActor* CurrentTarget = LockOnState.Target.Get();
+
+	FTargetSystemTargetingData CurrentTargetingData;
+	GetTargetingData(CurrentTarget, CurrentTargetingData);
 
 	// Depending on Axis Value negative / positive, set Direction to Look for (negative: left, positive: right)
 	const float RangeMin = AxisValue < 0 ? 0 : 180;
 	const float RangeMax = AxisValue < 0 ? 180 : 360;
 
 	// Reset Closest Target Distance to Minimum Distance to Enable
-	ClosestTargetDistance = MinimumDistanceToEnable;
-
-	// Get All Actors of Class
-	TArray<AActor*> Actors = GetAllActorsOfClass(TargetableActors);
+	ClosestTargetDistance = Settings.MinimumDistanceToEnable;
 
-	// For each of these actors, check line trace and ignore Current Target and build the list of actors to look from
-	TArray<AActor*> ActorsToLook;
+	// Get All Candidates of Class
+	FTargetSystemQueryScratchScope ScratchScope(QueryScratch);
+	Snapshot->Filter(GetCandidateFilter(), QueryScratch.Candidates);
+	RemoveOccludedCandidates(*Snapshot, QueryScratch.Candidates);
 
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(CurrentTarget);
-	for (AActor* Actor : Actors)
+	// For each of these candidates, check line trace and ignore Current Target and build the list of candidates to look from
+	TArray<int32>& CandidatesToLook = QueryScratch.VisibleCandidates;
+	for (const int32 Candidate : QueryScratch.Candidates)
 	{
-		const bool bHit = LineTraceForActor(Actor, ActorsToIgnore);
-		if (bHit && IsInViewport(Actor))
+		const FVector& AimPoint = Snapshot->AimPoints[Candidate];
+		const bool bHit = LineTraceForActor(Snapshot->Actors[Candidate], AimPoint, MakeArrayView(&CurrentTarget, 1));
+		if (bHit && IsInViewport(AimPoint))
 		{
-			ActorsToLook.Add(Actor);
+			CandidatesToLook.Add(Candidate);
 		}
 	}
 
 	// Find Targets in Range (left or right, based on Character and CurrentTarget)
-	TArray<AActor*> TargetsInRange = FindTargetsInRange(ActorsToLook, RangeMin, RangeMax);
+	TArray<int32>& TargetsInRange = QueryScratch.CandidatesInRange;
+	FindTargetsInRange(*Snapshot, CandidatesToLook, RangeMin, RangeMax, TargetsInRange);
 
 	// For each of these targets in range, get the closest one to current target
-	AActor* ActorToTarget = nullptr;
-	for (AActor* Actor : TargetsInRange)
+	TArray<float>& DistancesSquared = QueryScratch.DistancesSquared;
+	TArray<float>& RelativeDistancesSquared = QueryScratch.RelativeDistancesSquared;
+	Snapshot->GetDistancesSquared(OwnerActor->GetActorLocation(), TargetsInRange, DistancesSquared);
+	Snapshot->GetDistancesSquared(CurrentTargetingData.AimPoint, TargetsInRange, RelativeDistancesSquared);
+
+	// and filter out any character too distant from minimum distance to enable
+	const float MinimumDistanceToEnableSquared = FMath::Square(Settings.MinimumDistanceToEnable);
+	for (int32 Index = 0; Index < TargetsInRange.Num(); ++Index)
 	{
-		// and filter out any character too distant from minimum distance to enable
-		const float Distance = GetDistanceFromCharacter(Actor);
-		if (Distance < MinimumDistanceToEnable)
+		if (DistancesSquared[Index] >= MinimumDistanceToEnableSquared)
 		{
-			const float RelativeActorsDistance = CurrentTarget->GetDistanceTo(Actor);
-			if (RelativeActorsDistance < ClosestTargetDistance)
-			{
-				ClosestTargetDistance = RelativeActorsDistance;
-				ActorToTarget = Actor;
-			}
+			RelativeDistancesSquared[Index] = MAX_flt;
 		}
 	}
 
+	AActor* ActorToTarget = nullptr;
+	const int32 Closest = Snapshot->FindBest(TargetsInRange, RelativeDistancesSquared, FMath::Square(ClosestTargetDistance));
+	if (Closest != INDEX_NONE)
+	{
+		ClosestTargetDistance = FMath::Sqrt(RelativeDistancesSquared[Closest]);
+		ActorToTarget = Snapshot->Actors[TargetsInRange[Closest]];
+	}
+
 	if (ActorToTarget)
 	{
-		if (SwitchingTargetTimerHandle.IsValid())
-		{
-			SwitchingTargetTimerHandle.Invalidate();
-		}
-
 		TargetLockOff_Internal();
-		LockedOnTargetActor = ActorToTarget;
+		LockOnState.SwitchTarget(ActorToTarget);
 		TargetLockOn(ActorToTarget);
-
-		GetWorld()->GetTimerManager().SetTimer(
-			SwitchingTargetTimerHandle,
-			this,
-			&UTargetSystemComponent::ResetIsSwitchingTarget,
-			// Less sticky if still switching
-			bIsSwitchingTarget ? 0.25f : 0.5f
-		);
-
-		bIsSwitchingTarget = true;
 	}
 }
 
 bool UTargetSystemComponent::GetTargetLockedStatus()
 {
-	return bTargetLocked;
+	return LockOnState.bTargetLocked;
 }
 
 AActor* UTargetSystemComponent::GetLockedOnTargetActor() const
 {
-	return LockedOnTargetActor;
+	return LockOnState.Target.Get();
 }
 
 bool UTargetSystemComponent::IsLocked() const
 {
-	return bTargetLocked && LockedOnTargetActor;
+	return LockOnState.IsLocked();
 }
 
-TArray<AActor*> UTargetSystemComponent::FindTargetsInRange(TArray<AActor*> ActorsToLook, const float RangeMin, const float RangeMax) const
+const FTargetSystemLockOnState& UTargetSystemComponent::GetLockOnState() const
 {
-	TArray<AActor*> ActorsInRange;
+	return LockOnState;
+}
 
-	for (AActor* Actor : ActorsToLook)
-	{
-		const float Angle = GetAngleUsingCameraRotation(Actor);
-		if (Angle > RangeMin && Angle < RangeMax)
-		{
-			ActorsInRange.Add(Actor);
-		}
-	}
+void UTargetSystemComponent::SetLockOnState(const FTargetSystemLockOnState& InLockOnState)
+{
+	LockOnState = InLockOnState;
+}
 
-	return ActorsInRange;
+FTargetSystemLockOnParams UTargetSystemComponent::GetLockOnParams() const
+{
+	const FTargetSystemSettings& Settings = GetSettings();
+
+	FTargetSystemLockOnParams Params;
+	Params.MinimumDistanceToEnable = Settings.MinimumDistanceToEnable;
+	Params.LockOffDistance = Settings.LockOffDistance;
+	Params.LockOffGraceTime = Settings.LockOffGraceTime;
+	Params.RotationHalfLife = Settings.RotationHalfLife;
+	Params.BreakLineOfSightDelay = Settings.BreakLineOfSightDelay;
+	Params.StartRotatingThreshold = Settings.StartRotatingThreshold;
+	Params.bEnableStickyTarget = Settings.bEnableStickyTarget;
+	Params.AxisMultiplier = Settings.AxisMultiplier;
+	Params.StickyRotationThreshold = Settings.StickyRotationThreshold;
+	return Params;
 }
 
-float UTargetSystemComponent::GetAngleUsingCameraRotation(const AActor* ActorToLook) const
+void UTargetSystemComponent::FindTargetsInRange(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& CandidatesToLook, const float RangeMin, const float RangeMax, TArray<int32>& OutCandidatesInRange) const
 {
-	UCameraComponent* CameraComponent = OwnerActor->FindComponentByClass<UCameraComponent>();
-	if (!CameraComponent)
-	{
-		// Fallback to CharacterRotation if no CameraComponent can be found
-		return GetAngleUsingCharacterRotation(ActorToLook);
-	}
+	FVector ViewLocation;
+	float ViewYaw;
+	GetAngleViewPoint(ViewLocation, ViewYaw);
 
-	const FRotator CameraWorldRotation = CameraComponent->GetComponentRotation();
-	const FRotator LookAtRotation = FindLookAtRotation(CameraComponent->GetComponentLocation(), ActorToLook->GetActorLocation());
+	TArray<float>& Angles = QueryScratch.Angles;
+	Snapshot.GetYawAngles(ViewLocation, ViewYaw, CandidatesToLook, Angles);
 
-	float YawAngle = CameraWorldRotation.Yaw - LookAtRotation.Yaw;
-	if (YawAngle < 0)
+	for (int32 Index = 0; Index < CandidatesToLook.Num(); ++Index)
 	{
-		YawAngle = YawAngle + 360;
+		if (Angles[Index] > RangeMin && Angles[Index] < RangeMax)
+		{
+			OutCandidatesInRange.Add(CandidatesToLook[Index]);
+		}
 	}
-
-	return YawAngle;
 }
 
-float UTargetSystemComponent::GetAngleUsingCharacterRotation(const AActor* ActorToLook) const
+void UTargetSystemComponent::GetAngleViewPoint(FVector& OutViewLocation, float& OutViewYaw) const
 {
-	const FRotator CharacterRotation = OwnerActor->GetActorRotation();
-	const FRotator LookAtRotation = FindLookAtRotation(OwnerActor->GetActorLocation(), ActorToLook->GetActorLocation());
-
-	float YawAngle = CharacterRotation.Yaw - LookAtRotation.Yaw;
-	if (YawAngle < 0)
+	const UCameraComponent* CameraComponent = OwnerActor->FindComponentByClass<UCameraComponent>();
+	if (!CameraComponent)
 	{
-		YawAngle = YawAngle + 360;
+		// Fallback to CharacterRotation if no CameraComponent can be found
+		OutViewLocation = OwnerActor->GetActorLocation();
+		OutViewYaw = OwnerActor->GetActorRotation().Yaw;
+		return;
 	}
 
-	return YawAngle;
+	OutViewLocation = CameraComponent->GetComponentLocation();
+	OutViewYaw = CameraComponent->GetComponentRotation().Yaw;
 }
 
 FRotator UTargetSystemComponent::FindLookAtRotation(const FVector Start, const FVector Target)
@@ -277,50 +1140,6 @@ FRotator UTargetSystemComponent::FindLookAtRotation(const FVector Start, const F
 	return FRotationMatrix::MakeFromX(Target - Start).Rotator();
 }
 
-void UTargetSystemComponent::ResetIsSwitchingTarget()
-{
-	bIsSwitchingTarget = false;
-	bDesireToSwitch = false;
-}
-
-bool UTargetSystemComponent::ShouldSwitchTargetActor(const float AxisValue)
-{
-	// Sticky feeling computation
-	if (bEnableStickyTarget)
-	{
-		StartRotatingStack += (AxisValue != 0) ? AxisValue * AxisMultiplier : (StartRotatingStack > 0 ? -AxisMultiplier : AxisMultiplier);
-
-		if (AxisValue == 0 && FMath::Abs(StartRotatingStack) <= AxisMultiplier)
-		{
-			StartRotatingStack = 0.0f;
-		}
-
-		// If Axis value does not exceeds configured threshold, do nothing
-		if (FMath::Abs(StartRotatingStack) < StickyRotationThreshold)
-		{
-			bDesireToSwitch = false;
-			return false;
-		}
-
-		//Sticky when switching target.
-		if (StartRotatingStack * AxisValue > 0)
-		{
-			StartRotatingStack = StartRotatingStack > 0 ? StickyRotationThreshold : -StickyRotationThreshold;
-		}
-		else if (StartRotatingStack * AxisValue < 0)
-		{
-			StartRotatingStack = StartRotatingStack * -1.0f;
-		}
-
-		bDesireToSwitch = true;
-
-		return true;
-	}
-
-	// Non Sticky feeling, check Axis value exceeds threshold
-	return FMath::Abs(AxisValue) > StartRotatingThreshold;
-}
-
 void UTargetSystemComponent::TargetLockOn(AActor* TargetToLockOn)
 {
 	ServerTargetLockOn(TargetToLockOn);
@@ -331,6 +1150,8 @@ void UTargetSystemComponent::TargetLockOn(AActor* TargetToLockOn)
 
 void UTargetSystemComponent::TargetLockOn_Internal(AActor* TargetToLockOn)
 {
+	const FTargetSystemSettings& Settings = GetSettings();
+
 	if (!IsValid(TargetToLockOn))
 	{
 		return;
@@ -339,18 +1160,19 @@ void UTargetSystemComponent::TargetLockOn_Internal(AActor* TargetToLockOn)
 	// Recast PlayerController in case it wasn't already setup on Begin Play (local split screen)
 	SetupLocalPlayerController();
 
-	bTargetLocked = true;
-	if (bShouldDrawLockedOnWidget)
+	LockOnState.LockOn(TargetToLockOn);
+	BindLockedOnTargetEvents(TargetToLockOn);
+	if (Settings.bShouldDrawLockedOnWidget)
 	{
 		CreateAndAttachTargetLockedOnWidgetComponent(TargetToLockOn);
 	}
 
-	if (bShouldControlRotation)
+	if (Settings.bShouldControlRotation)
 	{
 		ControlRotation(true);
 	}
 
-	if (bAdjustPitchBasedOnDistanceToTarget || bIgnoreLookInput)
+	if (Settings.bAdjustPitchBasedOnDistanceToTarget || Settings.bIgnoreLookInput)
 	{
 		if (IsValid(OwnerPlayerController))
 		{
@@ -362,7 +1184,6 @@ void UTargetSystemComponent::TargetLockOn_Internal(AActor* TargetToLockOn)
 	{
 		OnTargetLockedOn.Broadcast(TargetToLockOn);
 	}
-	LockedOnTargetActor = TargetToLockOn;
 }
 
 void UTargetSystemComponent::TargetLockOff()
@@ -378,16 +1199,19 @@ void UTargetSystemComponent::TargetLockOff_Internal()
 	// Recast PlayerController in case it wasn't already setup on Begin Play (local split screen)
 	SetupLocalPlayerController();
 
-	bTargetLocked = false;
+	AActor* LockedOnTargetActor = LockOnState.Target.Get();
+	UnbindLockedOnTargetEvents(LockedOnTargetActor);
+	LockOnState.LockOff();
 	if (TargetLockedOnWidgetComponent)
 	{
 		TargetLockedOnWidgetComponent->DestroyComponent();
+		TargetLockedOnWidgetComponent = nullptr;
 	}
 
 	if (LockedOnTargetActor)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("LockedOnTargetActor is valid"));
-		if (bShouldControlRotation)
+		if (GetSettings().bShouldControlRotation)
 		{
 			UE_LOG(LogTemp, Warning, TEXT("Setting control rotation to false"));
 			ControlRotation(false);
@@ -403,25 +1227,229 @@ void UTargetSystemComponent::TargetLockOff_Internal()
 			OnTargetLockedOff.Broadcast(LockedOnTargetActor);
 		}
 	}
+}
+
+void UTargetSystemComponent::NotifyTargetabilityChanged(AActor* Target, const bool bIsTargetable)
+{
+	ITargetSystemTargetableInterface::NotifyTargetabilityChanged(Target, bIsTargetable);
+}
+
+void UTargetSystemComponent::NotifyGameplayTagsChanged(AActor* Target)
+{
+	ITargetSystemTargetableInterface::NotifyGameplayTagsChanged(Target);
+}
+
+const FTargetSystemSettings& UTargetSystemComponent::GetSettings() const
+{
+	if (PresetOverride)
+	{
+		return PresetOverride->Settings;
+	}
+
+	return Preset ? Preset->Settings : GetDefault<UTargetSystemPreset>()->Settings;
+}
+
+void UTargetSystemComponent::SetPreset(UTargetSystemPreset* InPreset)
+{
+	Preset = InPreset;
+	RegisterSettings();
+
+	CompileTargetTagQuery();
+}
+
+void UTargetSystemComponent::SetSettings(const FTargetSystemSettings& InSettings)
+{
+	GetOrCreatePresetOverride().Settings = InSettings;
+	RegisterSettings();
+
+	CompileTargetTagQuery();
+}
+
+void UTargetSystemComponent::ClearPresetOverride()
+{
+	PresetOverride = nullptr;
+	RegisterSettings();
+
+	CompileTargetTagQuery();
+}
+
+float UTargetSystemComponent::GetMinimumDistanceToEnable() const
+{
+	return GetSettings().MinimumDistanceToEnable;
+}
+
+void UTargetSystemComponent::SetMinimumDistanceToEnable(const float InMinimumDistanceToEnable)
+{
+	GetOrCreatePresetOverride().Settings.MinimumDistanceToEnable = InMinimumDistanceToEnable;
+}
+
+bool UTargetSystemComponent::GetShouldControlRotation() const
+{
+	return GetSettings().bShouldControlRotation;
+}
+
+void UTargetSystemComponent::SetShouldControlRotation(const bool bInShouldControlRotation)
+{
+	GetOrCreatePresetOverride().Settings.bShouldControlRotation = bInShouldControlRotation;
+}
+
+float UTargetSystemComponent::GetBreakLineOfSightDelay() const
+{
+	return GetSettings().BreakLineOfSightDelay;
+}
+
+void UTargetSystemComponent::SetBreakLineOfSightDelay(const float InBreakLineOfSightDelay)
+{
+	GetOrCreatePresetOverride().Settings.BreakLineOfSightDelay = InBreakLineOfSightDelay;
+}
+
+bool UTargetSystemComponent::GetShouldDrawLockedOnWidget() const
+{
+	return GetSettings().bShouldDrawLockedOnWidget;
+}
+
+void UTargetSystemComponent::SetShouldDrawLockedOnWidget(const bool bInShouldDrawLockedOnWidget)
+{
+	GetOrCreatePresetOverride().Settings.bShouldDrawLockedOnWidget = bInShouldDrawLockedOnWidget;
+}
+
+bool UTargetSystemComponent::GetEnableStickyTarget() const
+{
+	return GetSettings().bEnableStickyTarget;
+}
+
+void UTargetSystemComponent::SetEnableStickyTarget(const bool bInEnableStickyTarget)
+{
+	GetOrCreatePresetOverride().Settings.bEnableStickyTarget = bInEnableStickyTarget;
+}
+
+UTargetSystemPreset& UTargetSystemComponent::GetOrCreatePresetOverride()
+{
+	if (!PresetOverride)
+	{
+		const FTargetSystemSettings& Settings = GetSettings();
+		PresetOverride = NewObject<UTargetSystemPreset>(this, NAME_None, GetMaskedFlags(RF_PropagateToSubObjects));
+		PresetOverride->Settings = Settings;
+	}
+
+	return *PresetOverride;
+}
+
+void UTargetSystemComponent::SetTargetTagQuery(const FGameplayTagQuery& InTargetTagQuery)
+{
+	TargetTagQueryOverride = InTargetTagQuery;
+	CompileTargetTagQuery();
+}
+
+void UTargetSystemComponent::ClearTargetTagQuery()
+{
+	TargetTagQueryOverride.Reset();
+	CompileTargetTagQuery();
+}
+
+void UTargetSystemComponent::RegisterSettings()
+{
+	if (!TargetSystemSubsystem)
+	{
+		return;
+	}
+
+	const FTargetSystemSettings& Settings = GetSettings();
+	TargetSystemSubsystem->RegisterTargetableClass(Settings.TargetableActors, Settings.AimPointSocket);
+
+	FTargetSystemVisibilityPointSet PointSet;
+	PointSet.Sockets = Settings.VisibilityPointSockets;
+	PointSet.bTestBoundsCorners = Settings.bTestBoundsCorners;
+	PointSet.BoundsCornersScale = Settings.BoundsCornersScale;
+	VisibilityPointSet = TargetSystemSubsystem->RegisterVisibilityPointSet(PointSet);
+}
+
+void UTargetSystemComponent::CompileTargetTagQuery()
+{
+	// Compiled on BeginPlay when set before
+	if (TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->CompileTagQuery(TargetTagQueryOverride.Get(GetSettings().TargetTagQuery), CompiledTargetTagQuery);
+	}
+}
+
+void UTargetSystemComponent::OnTargetabilityChanged(AActor* Target, const bool bIsTargetable)
+{
+	if (!bIsTargetable && Target && Target == LockOnState.Target.Get())
+	{
+		TargetLockOff();
+	}
+}
+
+void UTargetSystemComponent::OnLockedOnTargetDestroyed(AActor* DestroyedActor)
+{
+	if (DestroyedActor == LockOnState.Target.Get())
+	{
+		TargetLockOff();
+	}
+}
+
+void UTargetSystemComponent::OnLockedOnTargetEndPlay(AActor* Actor, const EEndPlayReason::Type EndPlayReason)
+{
+	OnLockedOnTargetDestroyed(Actor);
+}
+
+void UTargetSystemComponent::BindLockedOnTargetEvents(AActor* Target)
+{
+	if (!IsValid(Target))
+	{
+		return;
+	}
+
+	Target->OnDestroyed.AddUniqueDynamic(this, &UTargetSystemComponent::OnLockedOnTargetDestroyed);
+	Target->OnEndPlay.AddUniqueDynamic(this, &UTargetSystemComponent::OnLockedOnTargetEndPlay);
+}
+
+void UTargetSystemComponent::UnbindLockedOnTargetEvents(AActor* Target)
+{
+	if (!Target)
+	{
+		return;
+	}
 
-	LockedOnTargetActor = nullptr;
+	Target->OnDestroyed.RemoveDynamic(this, &UTargetSystemComponent::OnLockedOnTargetDestroyed);
+	Target->OnEndPlay.RemoveDynamic(this, &UTargetSystemComponent::OnLockedOnTargetEndPlay);
 }
 
 void UTargetSystemComponent::CreateAndAttachTargetLockedOnWidgetComponent(AActor* TargetActor)
 {
+	const FTargetSystemSettings& Settings = GetSettings();
+
 	if ((GetOwnerRole() == ROLE_AutonomousProxy && GetOwner()->GetRemoteRole() != ROLE_SimulatedProxy) || (GetOwnerRole() == ROLE_Authority && GetOwner()->GetRemoteRole() == ROLE_SimulatedProxy))
 	{
-		if (!LockedOnWidgetClass)
+		if (Settings.LockedOnWidgetClass.IsNull())
 		{
 			TS_LOG(Error, TEXT("TargetSystemComponent: Cannot get LockedOnWidgetClass, please ensure it is a valid reference in the Component Properties."));
 			return;
 		}
 
+		UClass* WidgetClass = Settings.LockedOnWidgetClass.Get();
+		if (!WidgetClass)
+		{
+			// First time we need it, load it without blocking and draw the widget once loaded
+			LockedOnWidgetClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+				Settings.LockedOnWidgetClass.ToSoftObjectPath(),
+				FStreamableDelegate::CreateUObject(this, &UTargetSystemComponent::OnLockedOnWidgetClassLoaded)
+			);
+			return;
+		}
+
 		TargetLockedOnWidgetComponent = NewObject<UWidgetComponent>(TargetActor, MakeUniqueObjectName(TargetActor, UWidgetComponent::StaticClass(), FName("TargetLockOn")));
-		TargetLockedOnWidgetComponent->SetWidgetClass(LockedOnWidgetClass);
+		TargetLockedOnWidgetComponent->SetWidgetClass(WidgetClass);
 
-		UMeshComponent* MeshComponent = TargetActor->FindComponentByClass<UMeshComponent>();
-		USceneComponent* ParentComponent = MeshComponent && LockedOnWidgetParentSocket != NAME_None ? MeshComponent : TargetActor->GetRootComponent();
+		FTargetSystemTargetingData TargetingData;
+		GetTargetingData(TargetActor, TargetingData);
+		// Attach to the aim point socket when no widget socket is set, for the widget to show where traces and rotation aim at
+		const FName DefaultSocket = Settings.LockedOnWidgetParentSocket != NAME_None ? Settings.LockedOnWidgetParentSocket : Settings.AimPointSocket;
+		const FName ParentSocket = TargetingData.WidgetSocket != NAME_None ? TargetingData.WidgetSocket : DefaultSocket;
+
+		UMeshComponent* MeshComponent = ParentSocket != NAME_None ? TargetActor->FindComponentByClass<UMeshComponent>() : nullptr;
+		USceneComponent* ParentComponent = MeshComponent ? MeshComponent : TargetActor->GetRootComponent();
 
 		if (IsValid(OwnerPlayerController))
 		{
@@ -430,39 +1458,77 @@ void UTargetSystemComponent::CreateAndAttachTargetLockedOnWidgetComponent(AActor
 
 		TargetLockedOnWidgetComponent->ComponentTags.Add(FName("TargetSystem.LockOnWidget"));
 		TargetLockedOnWidgetComponent->SetWidgetSpace(EWidgetSpace::Screen);
-		TargetLockedOnWidgetComponent->SetupAttachment(ParentComponent, LockedOnWidgetParentSocket);
-		TargetLockedOnWidgetComponent->SetRelativeLocation(LockedOnWidgetRelativeLocation);
-		TargetLockedOnWidgetComponent->SetDrawSize(FVector2D(LockedOnWidgetDrawSize, LockedOnWidgetDrawSize));
+		TargetLockedOnWidgetComponent->SetupAttachment(ParentComponent, ParentSocket);
+		TargetLockedOnWidgetComponent->SetRelativeLocation(Settings.LockedOnWidgetRelativeLocation);
+		TargetLockedOnWidgetComponent->SetDrawSize(FVector2D(Settings.LockedOnWidgetDrawSize, Settings.LockedOnWidgetDrawSize));
 		TargetLockedOnWidgetComponent->SetVisibility(true);
 		TargetLockedOnWidgetComponent->RegisterComponent();
 	}
 }
 
-TArray<AActor*> UTargetSystemComponent::GetAllActorsOfClass(const TSubclassOf<AActor> ActorClass) const
+void UTargetSystemComponent::OnLockedOnWidgetClassLoaded()
 {
-	TArray<AActor*> Actors;
-	for (TActorIterator<AActor> ActorIterator(GetWorld(), ActorClass); ActorIterator; ++ActorIterator)
+	// We may have locked off, or failed to load the class, in the meantime
+	AActor* LockedOnTargetActor = LockOnState.Target.Get();
+	if (IsLocked() && LockedOnTargetActor && !TargetLockedOnWidgetComponent && GetSettings().LockedOnWidgetClass.Get())
 	{
-		AActor* Actor = *ActorIterator;
-		const bool bIsTargetable = TargetIsTargetable(Actor);
-		if (bIsTargetable)
-		{
-			Actors.Add(Actor);
-		}
+		CreateAndAttachTargetLockedOnWidgetComponent(LockedOnTargetActor);
+	}
+}
+
+const FTargetSystemCandidateSnapshot* UTargetSystemComponent::GetCandidateSnapshot() const
+{
+	const FTargetSystemSettings& Settings = GetSettings();
+
+	if (!TargetSystemSubsystem || !OwnerActor)
+	{
+		return nullptr;
+	}
+
+	// TargetableActors may have been changed since Begin Play, with another preset
+	TargetSystemSubsystem->RegisterTargetableClass(Settings.TargetableActors, Settings.AimPointSocket);
+
+	// Only visit the partitions within reach, targets further than MinimumDistanceToEnable can't be locked on anyway
+	if (!CandidateSnapshot || CandidateSnapshot->FrameNumber != GFrameCounter || CandidateSnapshot->Revision != TargetSystemSubsystem->GetRevision())
+	{
+		// Release the previous snapshot first, for the subsystem to reuse it
+		CandidateSnapshot.Reset();
+		CandidateSnapshot = TargetSystemSubsystem->GatherCandidates(OwnerActor->GetActorLocation(), Settings.MinimumDistanceToEnable);
 	}
 
-	return Actors;
+	return CandidateSnapshot.Get();
 }
 
-bool UTargetSystemComponent::TargetIsTargetable(const AActor* Actor)
+FTargetSystemCandidateFilter UTargetSystemComponent::GetCandidateFilter() const
 {
-	const bool bIsImplemented = Actor->GetClass()->ImplementsInterface(UTargetSystemTargetableInterface::StaticClass());
-	if (bIsImplemented)
+	const FTargetSystemSettings& Settings = GetSettings();
+
+	FTargetSystemCandidateFilter CandidateFilter;
+	CandidateFilter.IgnoredRelationBits = FTargetSystemTargetingData::MakeRelationBits(Settings.IgnoredTeamMask, Settings.IgnoredFactionMask);
+	CandidateFilter.TagQuery = &CompiledTargetTagQuery;
+	CandidateFilter.ActorClass = Settings.TargetableActors;
+
+	// Same threshold as AActor::WasRecentlyRendered, at least a frame for hitches not to discard every candidate
+	const UWorld* World = GetWorld();
+	if (Settings.bOnlyTargetRecentlyRendered && World && GetNetMode() != NM_DedicatedServer)
 	{
-		return ITargetSystemTargetableInterface::Execute_IsTargetable(Actor);
+		const float Tolerance = FMath::Max(Settings.RecentlyRenderedTolerance, World->GetDeltaSeconds() + UE_KINDA_SMALL_NUMBER);
+		CandidateFilter.MinLastRenderTime = World->GetTimeSeconds() - Tolerance;
 	}
 
-	return true;
+	return CandidateFilter;
+}
+
+void UTargetSystemComponent::GetTargetingData(const AActor* Actor, FTargetSystemTargetingData& OutTargetingData) const
+{
+	if (TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->GetTargetingData(Actor, OutTargetingData);
+	}
+	else if (IsValid(Actor))
+	{
+		OutTargetingData = FTargetSystemTargetingData::MakeDefault(Actor);
+	}
 }
 
 void UTargetSystemComponent::SetupLocalPlayerController()
@@ -476,51 +1542,118 @@ void UTargetSystemComponent::SetupLocalPlayerController()
 	OwnerPlayerController = Cast<APlayerController>(OwnerPawn->GetController());
 }
 
-AActor* UTargetSystemComponent::FindNearestTarget(TArray<AActor*> Actors) const
+void UTargetSystemComponent::RemoveOccludedCandidates(const FTargetSystemCandidateSnapshot& Snapshot, TArray<int32>& Candidates) const
 {
-	TArray<AActor*> ActorsHit;
+	if (!GetSettings().bUseOcclusionBuffer || !TargetSystemSubsystem || !IsValid(OwnerActor) || Candidates.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TargetSystemOcclusionBuffer);
 
-	// Find all actors we can line trace to
-	for (AActor* Actor : Actors)
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	float FOVDegrees;
+	float AspectRatio;
+	GetOcclusionView(ViewLocation, ViewRotation, FOVDegrees, AspectRatio);
+
+	const FTargetSystemOcclusionBuffer& OcclusionBuffer = TargetSystemSubsystem->GetOcclusionBuffer(ViewLocation, ViewRotation, FOVDegrees, AspectRatio);
+	const int32 NumRemoved = OcclusionBuffer.RemoveOccluded(Snapshot, Candidates);
+	INC_DWORD_STAT_BY(STAT_TargetSystemOcclusionBufferRejections, NumRemoved);
+}
+
+void UTargetSystemComponent::GetOcclusionView(FVector& OutViewLocation, FRotator& OutViewRotation, float& OutFOVDegrees, float& OutAspectRatio) const
+{
+	// The player camera when there is one, the owner eyes otherwise. Neither needs a viewport.
+	OutFOVDegrees = TargetSystemComponent::DefaultOcclusionFOV;
+	OutAspectRatio = TargetSystemComponent::DefaultOcclusionAspectRatio;
+	if (IsValid(OwnerPlayerController) && OwnerPlayerController->PlayerCameraManager)
 	{
-		TArray<AActor*> ActorsToIgnore;
-		const bool bHit = LineTraceForActor(Actor, ActorsToIgnore);
-		if (bHit && IsInViewport(Actor))
+		OwnerPlayerController->GetPlayerViewPoint(OutViewLocation, OutViewRotation);
+		OutFOVDegrees = OwnerPlayerController->PlayerCameraManager->GetFOVAngle();
+
+		FTargetSystemViewProjection ViewProjection;
+		ViewProjection.Capture(OwnerPlayerController);
+		if (ViewProjection.bIsValid && ViewProjection.ViewRect.Height() > 0)
 		{
-			ActorsHit.Add(Actor);
+			OutAspectRatio = static_cast<float>(ViewProjection.ViewRect.Width()) / ViewProjection.ViewRect.Height();
 		}
 	}
-
-	// From the hit actors, check distance and return the nearest
-	if (ActorsHit.Num() == 0)
+	else
 	{
-		return nullptr;
+		OwnerActor->GetActorEyesViewPoint(OutViewLocation, OutViewRotation);
 	}
+}
+
+AActor* UTargetSystemComponent::FindNearestTarget(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& Candidates) const
+{
+	TArray<int32>& CandidatesHit = QueryScratch.VisibleCandidates;
 
-	float ClosestDistance = ClosestTargetDistance;
-	AActor* Target = nullptr;
-	for (AActor* Actor : ActorsHit)
+	// Find all candidates in the viewport we can line trace to, only tracing the ones in the viewport
+	for (const int32 Candidate : Candidates)
 	{
-		const float Distance = GetDistanceFromCharacter(Actor);
-		if (Distance < ClosestDistance)
+		const FVector& AimPoint = Snapshot.AimPoints[Candidate];
+		if (IsInViewport(AimPoint) && LineTraceForActor(Snapshot.Actors[Candidate], AimPoint))
 		{
-			ClosestDistance = Distance;
-			Target = Actor;
+			CandidatesHit.Add(Candidate);
 		}
 	}
 
-	return Target;
+	// From the hit candidates, check distance and return the nearest
+	if (CandidatesHit.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	TArray<float>& DistancesSquared = QueryScratch.DistancesSquared;
+	Snapshot.GetDistancesSquared(OwnerActor->GetActorLocation(), CandidatesHit, DistancesSquared);
+
+	const int32 Closest = Snapshot.FindBest(CandidatesHit, DistancesSquared, FMath::Square(ClosestTargetDistance));
+	return Closest != INDEX_NONE ? Snapshot.Actors[CandidatesHit[Closest]] : nullptr;
 }
 
 
-bool UTargetSystemComponent::LineTraceForActor(const AActor* OtherActor, const TArray<AActor*>& ActorsToIgnore) const
+bool UTargetSystemComponent::LineTraceForActor(const AActor* OtherActor, const FVector& TargetLocation, const TArrayView<AActor* const> ActorsToIgnore) const
 {
-	FHitResult HitResult;
-	const bool bHit = LineTrace(HitResult, OtherActor, ActorsToIgnore);
-	if (bHit)
+	// Components querying from the same cell this frame share their results, see UTargetSystemSubsystem::FindCachedLineOfSight
+	const bool bCacheable = TargetSystemSubsystem && IsValid(OwnerActor) && ActorsToIgnore.Num() <= 1;
+	const AActor* IgnoredActor = ActorsToIgnore.Num() == 1 ? ActorsToIgnore[0] : nullptr;
+	const ECollisionChannel TraceChannel = GetSettings().TargetableCollisionChannel;
+
+	bool bVisible = false;
+	if (bCacheable && TargetSystemSubsystem->FindCachedLineOfSight(OwnerActor->GetActorLocation(), OtherActor, IgnoredActor, TraceChannel, VisibilityPointSet, bVisible))
+	{
+		return bVisible;
+	}
+
+	bVisible = TraceVisibilityPoints(OtherActor, TargetLocation, ActorsToIgnore, false);
+
+	if (bCacheable)
+	{
+		TargetSystemSubsystem->AddCachedLineOfSight(OwnerActor->GetActorLocation(), OtherActor, IgnoredActor, TraceChannel, VisibilityPointSet, bVisible);
+	}
+
+	return bVisible;
+}
+
+bool UTargetSystemComponent::TraceVisibilityPoints(const AActor* OtherActor, const FVector& TargetLocation, const TArrayView<AActor* const> ActorsToIgnore, const bool bVisibleIfUnobstructed) const
+{
+	// Most successful points first, for the average cost to stay close to a single trace
+	TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>> Points;
+	GetVisibilityPoints(OtherActor, TargetLocation, Points);
+
+	for (const FTargetSystemVisibilityPoint& Point : Points)
 	{
-		const AActor* HitActor = HitResult.GetActor();
-		if (HitActor == OtherActor)
+		FHitResult HitResult;
+		const bool bHit = LineTrace(HitResult, Point.Location, ActorsToIgnore);
+		const bool bVisible = bHit ? HitResult.GetActor() == OtherActor : bVisibleIfUnobstructed;
+
+		if (TargetSystemSubsystem)
+		{
+			TargetSystemSubsystem->ReportVisibilityPoint(OtherActor, VisibilityPointSet, Point.Index, bVisible);
+		}
+
+		if (bVisible)
 		{
 			return true;
 		}
@@ -529,7 +1662,19 @@ bool UTargetSystemComponent::LineTraceForActor(const AActor* OtherActor, const T
 	return false;
 }
 
-bool UTargetSystemComponent::LineTrace(FHitResult& OutHitResult, const AActor* OtherActor, const TArray<AActor*>& ActorsToIgnore) const
+void UTargetSystemComponent::GetVisibilityPoints(const AActor* OtherActor, const FVector& TargetLocation, TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>>& OutPoints) const
+{
+	if (TargetSystemSubsystem)
+	{
+		TargetSystemSubsystem->GetVisibilityPoints(OtherActor, VisibilityPointSet, TargetLocation, OutPoints);
+		return;
+	}
+
+	OutPoints.Reset();
+	OutPoints.Add({ 0, TargetLocation });
+}
+
+bool UTargetSystemComponent::LineTrace(FHitResult& OutHitResult, const FVector& TargetLocation, const TArrayView<AActor* const> ActorsToIgnore) const
 {
 	if (!IsValid(OwnerActor))
 	{
@@ -537,28 +1682,37 @@ bool UTargetSystemComponent::LineTrace(FHitResult& OutHitResult, const AActor* O
 		return false;
 	}
 	
-	if (!IsValid(OtherActor))
+	// Reuse the cached params, clearing the ignored actors keeps their allocation
+	TraceParams.ClearIgnoredActors();
+	TraceParams.AddIgnoredActor(OwnerActor);
+	for (const AActor* ActorToIgnore : ActorsToIgnore)
 	{
-		UE_LOG(LogTargetSystem, Warning, TEXT("UTargetSystemComponent::LineTrace - Called with invalid OtherActor: %s"), *GetNameSafe(OtherActor))
-		return false;
+		TraceParams.AddIgnoredActor(ActorToIgnore);
 	}
-	
-	TArray<AActor*> IgnoredActors;
-	IgnoredActors.Reserve(ActorsToIgnore.Num() + 1);
-	IgnoredActors.Add(OwnerActor);
-	IgnoredActors.Append(ActorsToIgnore);
-	
-	FCollisionQueryParams Params = FCollisionQueryParams(FName("LineTraceSingle"));
-	Params.AddIgnoredActors(IgnoredActors);
-	
+
+	const FVector Start = OwnerActor->GetActorLocation();
+	const ECollisionChannel TraceChannel = GetSettings().TargetableCollisionChannel;
+
+	// Blocked for sure when crossing an occluder proxy, reported as a blocking hit without an actor
+	if (TargetSystemSubsystem && TargetSystemSubsystem->IsOccluded(Start, TargetLocation))
+	{
+		OutHitResult = FHitResult(Start, TargetLocation);
+		OutHitResult.bBlockingHit = true;
+		return true;
+	}
+
+	// Static geometry is known not to block the way, only dynamic objects (the target included) need a trace
+	const bool bStaticallyClear = TargetSystemSubsystem && TargetSystemSubsystem->IsStaticallyClear(Start, TargetLocation, TraceChannel);
+	TraceParams.MobilityType = bStaticallyClear ? EQueryMobilityType::Dynamic : EQueryMobilityType::Any;
+
 	if (const UWorld* World = GetWorld(); IsValid(World))
 	{
 		return World->LineTraceSingleByChannel(
 			OutHitResult,
-			OwnerActor->GetActorLocation(),
-			OtherActor->GetActorLocation(),
-			TargetableCollisionChannel,
-			Params
+			Start,
+			TargetLocation,
+			TraceChannel,
+			TraceParams
 		);
 	}
 
@@ -566,35 +1720,36 @@ bool UTargetSystemComponent::LineTrace(FHitResult& OutHitResult, const AActor* O
 	return false;
 }
 
-FRotator UTargetSystemComponent::GetControlRotationOnTarget(const AActor* OtherActor) const
+FRotator UTargetSystemComponent::GetDesiredControlRotationOnTarget(const FVector& TargetLocation) const
 {
+	const FTargetSystemSettings& Settings = GetSettings();
+
 	if (!IsValid(OwnerPlayerController))
 	{
-		TS_LOG(Warning, TEXT("UTargetSystemComponent::GetControlRotationOnTarget - OwnerPlayerController is not valid ..."))
+		TS_LOG(Warning, TEXT("UTargetSystemComponent::GetDesiredControlRotationOnTarget - OwnerPlayerController is not valid ..."))
 		return FRotator::ZeroRotator;
 	}
 
 	const FRotator ControlRotation = OwnerPlayerController->GetControlRotation();
 
 	const FVector CharacterLocation = OwnerActor->GetActorLocation();
-	const FVector OtherActorLocation = OtherActor->GetActorLocation();
 
 	// Find look at rotation
-	const FRotator LookRotation = FRotationMatrix::MakeFromX(OtherActorLocation - CharacterLocation).Rotator();
+	const FRotator LookRotation = FRotationMatrix::MakeFromX(TargetLocation - CharacterLocation).Rotator();
 	float Pitch = LookRotation.Pitch;
 	FRotator TargetRotation;
-	if (bAdjustPitchBasedOnDistanceToTarget)
+	if (Settings.bAdjustPitchBasedOnDistanceToTarget)
 	{
-		const float DistanceToTarget = GetDistanceFromCharacter(OtherActor);
-		const float PitchInRange = (DistanceToTarget * PitchDistanceCoefficient + PitchDistanceOffset) * -1.0f;
-		const float PitchOffset = FMath::Clamp(PitchInRange, PitchMin, PitchMax);
+		const float DistanceToTarget = GetDistanceFromCharacter(TargetLocation);
+		const float PitchInRange = (DistanceToTarget * Settings.PitchDistanceCoefficient + Settings.PitchDistanceOffset) * -1.0f;
+		const float PitchOffset = FMath::Clamp(PitchInRange, Settings.PitchMin, Settings.PitchMax);
 
 		Pitch = Pitch + PitchOffset;
 		TargetRotation = FRotator(Pitch, LookRotation.Yaw, ControlRotation.Roll);
 	}
 	else
 	{
-		if (bIgnoreLookInput)
+		if (Settings.bIgnoreLookInput)
 		{
 			TargetRotation = FRotator(Pitch, LookRotation.Yaw, ControlRotation.Roll);
 		}
@@ -604,17 +1759,16 @@ FRotator UTargetSystemComponent::GetControlRotationOnTarget(const AActor* OtherA
 		}
 	}
 
-	return FMath::RInterpTo(ControlRotation, TargetRotation, GetWorld()->GetDeltaSeconds(), 9.0f);
+	return TargetRotation;
 }
 
-void UTargetSystemComponent::SetControlRotationOnTarget(AActor* TargetActor) const
+void UTargetSystemComponent::SetControlRotationOnTarget(AActor* TargetActor, const FRotator& ControlRotation) const
 {
 	if (!IsValid(OwnerPlayerController))
 	{
 		return;
 	}
 
-	const FRotator ControlRotation = GetControlRotationOnTarget(TargetActor);
 	if (OnTargetSetRotation.IsBound())
 	{
 		OnTargetSetRotation.Broadcast(TargetActor, ControlRotation);
@@ -625,38 +1779,37 @@ void UTargetSystemComponent::SetControlRotationOnTarget(AActor* TargetActor) con
 	}
 }
 
-float UTargetSystemComponent::GetDistanceFromCharacter(const AActor* OtherActor) const
+float UTargetSystemComponent::GetDistanceFromCharacter(const FVector& TargetLocation) const
 {
-	return OwnerActor->GetDistanceTo(OtherActor);
+	return FVector::Dist(OwnerActor->GetActorLocation(), TargetLocation);
 }
 
-bool UTargetSystemComponent::ShouldBreakLineOfSight() const
+bool UTargetSystemComponent::ShouldBreakLineOfSight(const FVector& TargetLocation) const
 {
+	AActor* LockedOnTargetActor = LockOnState.Target.Get();
 	if (!LockedOnTargetActor)
 	{
 		return true;
 	}
 
-	TArray<AActor*> ActorsToIgnore = GetAllActorsOfClass(TargetableActors);
-	ActorsToIgnore.Remove(LockedOnTargetActor);
-
-	FHitResult HitResult;
-	const bool bHit = LineTrace(HitResult, LockedOnTargetActor, ActorsToIgnore);
-	if (bHit && HitResult.GetActor() != LockedOnTargetActor)
+	FTargetSystemQueryScratchScope ScratchScope(QueryScratch);
+	TArray<AActor*>& ActorsToIgnore = QueryScratch.ActorsToIgnore;
+	if (const FTargetSystemCandidateSnapshot* Snapshot = GetCandidateSnapshot())
 	{
-		return true;
+		// Allies, neutrals and targets filtered out by tags should not block the line of sight either, so only filter on class here
+		FTargetSystemCandidateFilter CandidateFilter;
+		CandidateFilter.ActorClass = GetSettings().TargetableActors;
+		Snapshot->Filter(CandidateFilter, QueryScratch.Candidates);
+		for (const int32 Candidate : QueryScratch.Candidates)
+		{
+			if (Snapshot->Actors[Candidate] != LockedOnTargetActor)
+			{
+				ActorsToIgnore.Add(Snapshot->Actors[Candidate]);
+			}
+		}
 	}
 
-	return false;
-}
-
-void UTargetSystemComponent::BreakLineOfSight()
-{
-	bIsBreakingLineOfSight = false;
-	if (ShouldBreakLineOfSight())
-	{
-		TargetLockOff();
-	}
+	return !TraceVisibilityPoints(LockedOnTargetActor, TargetLocation, ActorsToIgnore, true);
 }
 
 void UTargetSystemComponent::ControlRotation(const bool ShouldControlRotation) const
@@ -675,7 +1828,7 @@ void UTargetSystemComponent::ControlRotation(const bool ShouldControlRotation) c
 	}
 }
 
-bool UTargetSystemComponent::IsInViewport(const AActor* TargetActor) const
+bool UTargetSystemComponent::IsInViewport(const FVector& TargetLocation) const
 {
 	if (!IsValid(OwnerPlayerController))
 	{
@@ -683,7 +1836,7 @@ bool UTargetSystemComponent::IsInViewport(const AActor* TargetActor) const
 	}
 
 	FVector2D ScreenLocation;
-	OwnerPlayerController->ProjectWorldLocationToScreen(TargetActor->GetActorLocation(), ScreenLocation);
+	OwnerPlayerController->ProjectWorldLocationToScreen(TargetLocation, ScreenLocation);
 
 	FVector2D ViewportSize;
 	GetWorld()->GetGameViewport()->GetViewportSize(ViewportSize);
@@ -714,4 +1867,4 @@ void UTargetSystemComponent::ClientTargetLockOff_Implementation()
 	// if (GetOwnerRole() >= ROLE_AutonomousProxy)
 	// 	return;
 	TargetLockOff_Internal();
-}
\ No newline at end of file
+}
\ No newline at end of file
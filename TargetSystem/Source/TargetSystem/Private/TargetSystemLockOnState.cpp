@@ -0,0 +1,148 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemLockOnState.h"
+#include "GameFramework/Actor.h"
+
+bool FTargetSystemLockOnState::IsLocked() const
+{
+	return bTargetLocked && Target.IsValid();
+}
+
+void FTargetSystemLockOnState::LockOn(AActor* NewTarget)
+{
+	bTargetLocked = true;
+	Target = NewTarget;
+	bIsBreakingLineOfSight = false;
+	bIsOutOfRange = false;
+	RotationSolver.Reset();
+}
+
+void FTargetSystemLockOnState::LockOff()
+{
+	bTargetLocked = false;
+	Target = nullptr;
+	RotationSolver.Reset();
+}
+
+void FTargetSystemLockOnState::SwitchTarget(AActor* NewTarget)
+{
+	Target = NewTarget;
+
+	// Less sticky if still switching
+	SwitchingTargetEndTime = Time + (bIsSwitchingTarget ? 0.25f : 0.5f);
+	bIsSwitchingTarget = true;
+}
+
+FTargetSystemLockOnOutput FTargetSystemLockOnState::Step(const FTargetSystemLockOnParams& Params, const FTargetSystemLockOnInput& Input, const float DeltaTime)
+{
+	FTargetSystemLockOnOutput Output;
+
+	Time += DeltaTime;
+
+	if (bIsSwitchingTarget && Time >= SwitchingTargetEndTime)
+	{
+		bIsSwitchingTarget = false;
+		bDesireToSwitch = false;
+	}
+
+	if (!IsLocked())
+	{
+		return Output;
+	}
+
+	if (Input.bHasDesiredRotation)
+	{
+		Output.ControlRotation = RotationSolver.Step(Input.ControlRotation, Input.DesiredRotation, Params.RotationHalfLife, DeltaTime);
+		Output.bHasControlRotation = true;
+	}
+
+	// Range and line of sight are only known on steps gathering the target state, not on switch axis input alone
+	if (Input.bHasTargetState)
+	{
+		// Target Locked Off based on Distance, once it's been further than LockOffDistance for LockOffGraceTime. Releasing
+		// further than we acquire keeps targets moving around MinimumDistanceToEnable from being locked on and off repeatedly.
+		if (Input.DistanceToTarget > FMath::Max(Params.MinimumDistanceToEnable, Params.LockOffDistance))
+		{
+			if (!bIsOutOfRange)
+			{
+				bIsOutOfRange = true;
+				OutOfRangeLockOffTime = Time + Params.LockOffGraceTime;
+			}
+
+			Output.bShouldLockOff |= Time >= OutOfRangeLockOffTime;
+		}
+		else
+		{
+			bIsOutOfRange = false;
+		}
+
+		// Target Locked Off based on Line of Sight, once it's been blocked for BreakLineOfSightDelay
+		if (bIsBreakingLineOfSight)
+		{
+			if (Time >= LineOfSightBreakTime)
+			{
+				bIsBreakingLineOfSight = false;
+				Output.bShouldLockOff |= Input.bLineOfSightBlocked;
+			}
+		}
+		else if (Input.bLineOfSightBlocked)
+		{
+			if (Params.BreakLineOfSightDelay <= 0)
+			{
+				Output.bShouldLockOff = true;
+			}
+			else
+			{
+				bIsBreakingLineOfSight = true;
+				LineOfSightBreakTime = Time + Params.BreakLineOfSightDelay;
+			}
+		}
+	}
+
+	// If we're switching target, do nothing for a set amount of time
+	if (Input.bHasSwitchAxisInput && ShouldSwitchTarget(Params, Input.SwitchAxisValue) && !bIsSwitchingTarget)
+	{
+		Output.bShouldSwitchTarget = true;
+		Output.SwitchAxisValue = Input.SwitchAxisValue;
+	}
+
+	return Output;
+}
+
+bool FTargetSystemLockOnState::ShouldSwitchTarget(const FTargetSystemLockOnParams& Params, const float AxisValue)
+{
+	// Sticky feeling computation
+	if (Params.bEnableStickyTarget)
+	{
+		StartRotatingStack += (AxisValue != 0) ? AxisValue * Params.AxisMultiplier : (StartRotatingStack > 0 ? -Params.AxisMultiplier : Params.AxisMultiplier);
+
+		if (AxisValue == 0 && FMath::Abs(StartRotatingStack) <= Params.AxisMultiplier)
+		{
+			StartRotatingStack = 0.0f;
+		}
+
+		// If Axis value does not exceeds configured threshold, do nothing
+		if (FMath::Abs(StartRotatingStack) < Params.StickyRotationThreshold)
+		{
+			bDesireToSwitch = false;
+			return false;
+		}
+
+		//Sticky when switching target.
+		if (StartRotatingStack * AxisValue > 0)
+		{
+			StartRotatingStack = StartRotatingStack > 0 ? Params.StickyRotationThreshold : -Params.StickyRotationThreshold;
+		}
+		else if (StartRotatingStack * AxisValue < 0)
+		{
+			StartRotatingStack = StartRotatingStack * -1.0f;
+		}
+
+		bDesireToSwitch = true;
+
+		return true;
+	}
+
+	// Non Sticky feeling, check Axis value exceeds threshold
+	return FMath::Abs(AxisValue) > Params.StartRotatingThreshold;
+}
@@ -0,0 +1,90 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemOccluderComponent.h"
+#include "TargetSystemOccluderSet.h"
+#include "TargetSystemSubsystem.h"
+#include "Engine/World.h"
+
+UTargetSystemOccluderComponent::UTargetSystemOccluderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	Shape = ETargetSystemOccluderShape::Box;
+	BoxExtent = FVector(50.0f);
+	SphereRadius = 50.0f;
+	CapsuleRadius = 50.0f;
+	CapsuleHalfHeight = 100.0f;
+}
+
+void UTargetSystemOccluderComponent::AddTo(FTargetSystemOccluderSet& Occluders) const
+{
+	const FTransform& Transform = GetComponentTransform();
+	const FVector Scale = Transform.GetScale3D().GetAbs();
+
+	switch (Shape)
+	{
+	case ETargetSystemOccluderShape::Box:
+		Occluders.AddBox(Transform.GetLocation(), Transform.GetRotation(), BoxExtent * Scale);
+		break;
+	case ETargetSystemOccluderShape::Sphere:
+		Occluders.AddSphere(Transform.GetLocation(), SphereRadius * Scale.GetMin());
+		break;
+	case ETargetSystemOccluderShape::Capsule:
+	{
+		// Non uniform scales shrink the capsule to the largest one fitting within the scaled shape
+		const float Radius = CapsuleRadius * FMath::Min(Scale.X, Scale.Y);
+		const float SegmentHalfLength = FMath::Max(CapsuleHalfHeight * Scale.Z - Radius, 0.0f);
+		const FVector Axis = Transform.GetRotation().GetAxisZ() * SegmentHalfLength;
+		Occluders.AddCapsule(Transform.GetLocation() - Axis, Transform.GetLocation() + Axis, Radius);
+		break;
+	}
+	}
+}
+
+void UTargetSystemOccluderComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (UTargetSystemSubsystem* Subsystem = GetSubsystem())
+	{
+		Subsystem->RegisterOccluder(this);
+	}
+}
+
+void UTargetSystemOccluderComponent::OnUnregister()
+{
+	if (UTargetSystemSubsystem* Subsystem = GetSubsystem())
+	{
+		Subsystem->UnregisterOccluder(this);
+	}
+
+	Super::OnUnregister();
+}
+
+void UTargetSystemOccluderComponent::OnUpdateTransform(const EUpdateTransformFlags UpdateTransformFlags, const ETeleportType Teleport)
+{
+	Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+
+	if (UTargetSystemSubsystem* Subsystem = GetSubsystem())
+	{
+		Subsystem->MarkOccludersDirty();
+	}
+}
+
+#if WITH_EDITOR
+void UTargetSystemOccluderComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (UTargetSystemSubsystem* Subsystem = GetSubsystem())
+	{
+		Subsystem->MarkOccludersDirty();
+	}
+}
+#endif
+
+UTargetSystemSubsystem* UTargetSystemOccluderComponent::GetSubsystem() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UTargetSystemSubsystem>() : nullptr;
+}
@@ -0,0 +1,140 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemOccluderSet.h"
+
+namespace TargetSystemOccluderSet
+{
+	// Squared distance from Point to the segment from Start to Start + Direction.
+	static float PointSegmentDistSquared(const FVector3f& Point, const FVector3f& Start, const FVector3f& Direction, const float DirectionSizeSquared)
+	{
+		const float T = DirectionSizeSquared > UE_SMALL_NUMBER ? FMath::Clamp(FVector3f::DotProduct(Point - Start, Direction) / DirectionSizeSquared, 0.0f, 1.0f) : 0.0f;
+		return FVector3f::DistSquared(Start + Direction * T, Point);
+	}
+
+	// Squared distance between the segments from P0 to P0 + D1 and from Q0 to Q0 + D2 (Real-Time Collision Detection, 5.1.9).
+	static float SegmentSegmentDistSquared(const FVector3f& P0, const FVector3f& D1, const FVector3f& Q0, const FVector3f& D2)
+	{
+		const FVector3f R = P0 - Q0;
+		const float A = FVector3f::DotProduct(D1, D1);
+		const float E = FVector3f::DotProduct(D2, D2);
+		const float F = FVector3f::DotProduct(D2, R);
+		const float C = FVector3f::DotProduct(D1, R);
+		const float B = FVector3f::DotProduct(D1, D2);
+		const float Denominator = A * E - B * B;
+
+		// Parallel segments pick any S, the clamps below fix it up
+		float S = Denominator > UE_SMALL_NUMBER ? FMath::Clamp((B * F - C * E) / Denominator, 0.0f, 1.0f) : 0.0f;
+		float T = E > UE_SMALL_NUMBER ? (B * S + F) / E : 0.0f;
+		if (T < 0.0f)
+		{
+			T = 0.0f;
+			S = A > UE_SMALL_NUMBER ? FMath::Clamp(-C / A, 0.0f, 1.0f) : 0.0f;
+		}
+		else if (T > 1.0f)
+		{
+			T = 1.0f;
+			S = A > UE_SMALL_NUMBER ? FMath::Clamp((B - C) / A, 0.0f, 1.0f) : 0.0f;
+		}
+
+		return FVector3f::DistSquared(P0 + D1 * S, Q0 + D2 * T);
+	}
+}
+
+void FTargetSystemOccluderSet::Reset(const FVector& NewOrigin)
+{
+	Origin = NewOrigin;
+	BoxCenters.Reset();
+	BoxAxesX.Reset();
+	BoxAxesY.Reset();
+	BoxAxesZ.Reset();
+	BoxExtents.Reset();
+	SphereCenters.Reset();
+	SphereRadii.Reset();
+	CapsuleStarts.Reset();
+	CapsuleEnds.Reset();
+	CapsuleRadii.Reset();
+}
+
+void FTargetSystemOccluderSet::AddBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent)
+{
+	BoxCenters.Add(ToRelative(Center));
+	BoxAxesX.Add(FVector3f(Rotation.GetAxisX()));
+	BoxAxesY.Add(FVector3f(Rotation.GetAxisY()));
+	BoxAxesZ.Add(FVector3f(Rotation.GetAxisZ()));
+	BoxExtents.Add(FVector3f(Extent));
+}
+
+void FTargetSystemOccluderSet::AddSphere(const FVector& Center, const float Radius)
+{
+	SphereCenters.Add(ToRelative(Center));
+	SphereRadii.Add(Radius);
+}
+
+void FTargetSystemOccluderSet::AddCapsule(const FVector& Start, const FVector& End, const float Radius)
+{
+	CapsuleStarts.Add(ToRelative(Start));
+	CapsuleEnds.Add(ToRelative(End));
+	CapsuleRadii.Add(Radius);
+}
+
+bool FTargetSystemOccluderSet::IsSegmentBlocked(const FVector& Start, const FVector& End) const
+{
+	const FVector3f P0 = ToRelative(Start);
+	const FVector3f P1 = ToRelative(End);
+	const FVector3f Direction = P1 - P0;
+	const float DirectionSizeSquared = Direction.SizeSquared();
+
+	// Accumulate instead of returning on the first hit, for loops to stay branch free
+	uint32 bBlocked = 0;
+
+	for (int32 Index = 0; Index < SphereCenters.Num(); ++Index)
+	{
+		const float RadiusSquared = FMath::Square(SphereRadii[Index]);
+		const FVector3f& Center = SphereCenters[Index];
+		const uint32 bStartInside = FVector3f::DistSquared(P0, Center) <= RadiusSquared;
+		const uint32 bEndInside = FVector3f::DistSquared(P1, Center) <= RadiusSquared;
+		const uint32 bCrosses = TargetSystemOccluderSet::PointSegmentDistSquared(Center, P0, Direction, DirectionSizeSquared) < RadiusSquared;
+		bBlocked |= bCrosses & ~(bStartInside | bEndInside) & 1u;
+	}
+
+	for (int32 Index = 0; Index < BoxCenters.Num(); ++Index)
+	{
+		// Slab test in box space
+		const FVector3f Relative = P0 - BoxCenters[Index];
+		const FVector3f LocalStart(FVector3f::DotProduct(Relative, BoxAxesX[Index]), FVector3f::DotProduct(Relative, BoxAxesY[Index]), FVector3f::DotProduct(Relative, BoxAxesZ[Index]));
+		const FVector3f LocalDirection(FVector3f::DotProduct(Direction, BoxAxesX[Index]), FVector3f::DotProduct(Direction, BoxAxesY[Index]), FVector3f::DotProduct(Direction, BoxAxesZ[Index]));
+		const FVector3f LocalEnd = LocalStart + LocalDirection;
+		const FVector3f& Extent = BoxExtents[Index];
+
+		float EnterTime = 0.0f;
+		float ExitTime = 1.0f;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			// Nudge axis aligned directions, an infinite inverse would turn into NaNs on the slab boundaries
+			const float AxisDirection = FMath::Abs(LocalDirection[Axis]) > UE_SMALL_NUMBER ? LocalDirection[Axis] : UE_SMALL_NUMBER;
+			const float T0 = (-Extent[Axis] - LocalStart[Axis]) / AxisDirection;
+			const float T1 = (Extent[Axis] - LocalStart[Axis]) / AxisDirection;
+			EnterTime = FMath::Max(EnterTime, FMath::Min(T0, T1));
+			ExitTime = FMath::Min(ExitTime, FMath::Max(T0, T1));
+		}
+
+		const uint32 bStartInside = FMath::Abs(LocalStart.X) <= Extent.X && FMath::Abs(LocalStart.Y) <= Extent.Y && FMath::Abs(LocalStart.Z) <= Extent.Z;
+		const uint32 bEndInside = FMath::Abs(LocalEnd.X) <= Extent.X && FMath::Abs(LocalEnd.Y) <= Extent.Y && FMath::Abs(LocalEnd.Z) <= Extent.Z;
+		const uint32 bCrosses = EnterTime < ExitTime;
+		bBlocked |= bCrosses & ~(bStartInside | bEndInside) & 1u;
+	}
+
+	for (int32 Index = 0; Index < CapsuleStarts.Num(); ++Index)
+	{
+		const float RadiusSquared = FMath::Square(CapsuleRadii[Index]);
+		const FVector3f& CapsuleStart = CapsuleStarts[Index];
+		const FVector3f CapsuleDirection = CapsuleEnds[Index] - CapsuleStart;
+		const float CapsuleSizeSquared = CapsuleDirection.SizeSquared();
+		const uint32 bStartInside = TargetSystemOccluderSet::PointSegmentDistSquared(P0, CapsuleStart, CapsuleDirection, CapsuleSizeSquared) <= RadiusSquared;
+		const uint32 bEndInside = TargetSystemOccluderSet::PointSegmentDistSquared(P1, CapsuleStart, CapsuleDirection, CapsuleSizeSquared) <= RadiusSquared;
+		const uint32 bCrosses = TargetSystemOccluderSet::SegmentSegmentDistSquared(P0, Direction, CapsuleStart, CapsuleDirection) < RadiusSquared;
+		bBlocked |= bCrosses & ~(bStartInside | bEndInside) & 1u;
+	}
+
+	return bBlocked != 0;
+}
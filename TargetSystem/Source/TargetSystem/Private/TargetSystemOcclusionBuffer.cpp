@@ -0,0 +1,295 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemOcclusionBuffer.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemOccluderSet.h"
+
+namespace TargetSystemOcclusionBuffer
+{
+	// Points closer to the view than this are not projected: occluders crossing it are skipped, and candidates crossing
+	// it never occluded.
+	static constexpr float NearPlane = 10.0f;
+
+	// Half extent of the cube fitting within a sphere of radius 1.
+	static constexpr float InscribedCubeScale = 0.57735027f;
+
+	using FPolygon = TArray<FVector2f, TInlineAllocator<16>>;
+
+	// Sets OutHull to the convex hull of Points, counter clockwise (Andrew's monotone chain).
+	static void ComputeConvexHull(TArray<FVector2f, TInlineAllocator<8>>& Points, FPolygon& OutHull)
+	{
+		Points.Sort([](const FVector2f& A, const FVector2f& B)
+		{
+			return A.X < B.X || (A.X == B.X && A.Y < B.Y);
+		});
+
+		auto Cross = [](const FVector2f& O, const FVector2f& A, const FVector2f& B)
+		{
+			return (A.X - O.X) * (B.Y - O.Y) - (A.Y - O.Y) * (B.X - O.X);
+		};
+
+		OutHull.Reset();
+		for (const FVector2f& Point : Points)
+		{
+			while (OutHull.Num() >= 2 && Cross(OutHull[OutHull.Num() - 2], OutHull.Last(), Point) <= 0.0f)
+			{
+				OutHull.Pop();
+			}
+			OutHull.Add(Point);
+		}
+
+		const int32 LowerNum = OutHull.Num() + 1;
+		for (int32 Index = Points.Num() - 2; Index >= 0; --Index)
+		{
+			while (OutHull.Num() >= LowerNum && Cross(OutHull[OutHull.Num() - 2], OutHull.Last(), Points[Index]) <= 0.0f)
+			{
+				OutHull.Pop();
+			}
+			OutHull.Add(Points[Index]);
+		}
+
+		// Last point is the first one again
+		OutHull.Pop();
+	}
+
+	// Returns the horizontal extent of the convex Polygon at Y, false when Y is outside of it.
+	static bool GetPolygonSpan(const TArrayView<const FVector2f> Polygon, const float Y, float& OutMinX, float& OutMaxX)
+	{
+		OutMinX = TNumericLimits<float>::Max();
+		OutMaxX = TNumericLimits<float>::Lowest();
+		for (int32 Index = 0; Index < Polygon.Num(); ++Index)
+		{
+			const FVector2f& A = Polygon[Index];
+			const FVector2f& B = Polygon[(Index + 1) % Polygon.Num()];
+			if ((Y < A.Y && Y < B.Y) || (Y > A.Y && Y > B.Y))
+			{
+				continue;
+			}
+
+			// Horizontal edges contribute both of their ends
+			const float StartX = A.Y != B.Y ? A.X + (Y - A.Y) * (B.X - A.X) / (B.Y - A.Y) : A.X;
+			const float EndX = A.Y != B.Y ? StartX : B.X;
+			OutMinX = FMath::Min3(OutMinX, StartX, EndX);
+			OutMaxX = FMath::Max3(OutMaxX, StartX, EndX);
+		}
+
+		return OutMinX <= OutMaxX;
+	}
+}
+
+void FTargetSystemOcclusionBuffer::Init(const FVector& InViewLocation, const FRotator& ViewRotation, const float FOVDegrees, const float AspectRatio, const int32 InWidth)
+{
+	Width = FMath::Max(InWidth, 1);
+	Height = FMath::Max(FMath::RoundToInt(Width / FMath::Max(AspectRatio, UE_KINDA_SMALL_NUMBER)), 1);
+
+	const FRotationMatrix ViewRotationMatrix(ViewRotation);
+	ViewLocation = InViewLocation;
+	ViewForward = FVector3f(ViewRotationMatrix.GetScaledAxis(EAxis::X));
+	ViewRight = FVector3f(ViewRotationMatrix.GetScaledAxis(EAxis::Y));
+	ViewUp = FVector3f(ViewRotationMatrix.GetScaledAxis(EAxis::Z));
+	PixelScale = Width * 0.5f / FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOVDegrees, 1.0f, 170.0f) * 0.5f));
+
+	// Keeps the allocation from one frame to the next
+	Depths.SetNumUninitialized(Width * Height);
+	for (float& Depth : Depths)
+	{
+		Depth = TNumericLimits<float>::Max();
+	}
+}
+
+void FTargetSystemOcclusionBuffer::RasterizeOccluders(const FTargetSystemOccluderSet& Occluders)
+{
+	if (!IsValid())
+	{
+		return;
+	}
+
+	const FVector3f Offset(Occluders.Origin - ViewLocation);
+
+	for (int32 Index = 0; Index < Occluders.BoxCenters.Num(); ++Index)
+	{
+		const FVector3f Axes[3] = { Occluders.BoxAxesX[Index], Occluders.BoxAxesY[Index], Occluders.BoxAxesZ[Index] };
+		RasterizeBox(Occluders.BoxCenters[Index] + Offset, Axes, Occluders.BoxExtents[Index]);
+	}
+
+	for (int32 Index = 0; Index < Occluders.SphereCenters.Num(); ++Index)
+	{
+		const FVector3f Axes[3] = { FVector3f::ForwardVector, FVector3f::RightVector, FVector3f::UpVector };
+		RasterizeBox(Occluders.SphereCenters[Index] + Offset, Axes, FVector3f(Occluders.SphereRadii[Index] * TargetSystemOcclusionBuffer::InscribedCubeScale));
+	}
+
+	for (int32 Index = 0; Index < Occluders.CapsuleStarts.Num(); ++Index)
+	{
+		// Box along the capsule cylinder, with a square section fitting within it
+		const FVector3f Segment = Occluders.CapsuleEnds[Index] - Occluders.CapsuleStarts[Index];
+		const FVector3f Center = (Occluders.CapsuleStarts[Index] + Occluders.CapsuleEnds[Index]) * 0.5f + Offset;
+		const float Radius = Occluders.CapsuleRadii[Index];
+		const float Length = Segment.Size();
+
+		FVector3f Axes[3] = { FVector3f::ForwardVector, FVector3f::RightVector, FVector3f::UpVector };
+		FVector3f Extent(Radius * TargetSystemOcclusionBuffer::InscribedCubeScale);
+		if (Length > UE_KINDA_SMALL_NUMBER)
+		{
+			Axes[0] = Segment / Length;
+			Axes[0].FindBestAxisVectors(Axes[1], Axes[2]);
+			Extent = FVector3f(Length * 0.5f, Radius * UE_INV_SQRT_2, Radius * UE_INV_SQRT_2);
+		}
+
+		RasterizeBox(Center, Axes, Extent);
+	}
+}
+
+bool FTargetSystemOcclusionBuffer::IsSphereOccluded(const FVector& Center, const float Radius) const
+{
+	return IsValid() && IsRelativeSphereOccluded(FVector3f(Center - ViewLocation), Radius);
+}
+
+int32 FTargetSystemOcclusionBuffer::RemoveOccluded(const FTargetSystemCandidateSnapshot& Snapshot, TArray<int32>& Candidates) const
+{
+	if (!IsValid())
+	{
+		return 0;
+	}
+
+	const FVector3f Offset(Snapshot.Origin - ViewLocation);
+	const FVector3f* Points = Snapshot.RelativeAimPoints.GetData();
+	const float* Radii = Snapshot.BoundingRadii.GetData();
+
+	const int32 NumCandidates = Candidates.Num();
+	Candidates.RemoveAll([this, &Offset, Points, Radii](const int32 Candidate)
+	{
+		return IsRelativeSphereOccluded(Points[Candidate] + Offset, Radii[Candidate]);
+	});
+
+	return NumCandidates - Candidates.Num();
+}
+
+bool FTargetSystemOcclusionBuffer::Project(const FVector3f& Point, FVector2f& OutPixel, float& OutDepth) const
+{
+	OutDepth = FVector3f::DotProduct(Point, ViewForward);
+	if (OutDepth < TargetSystemOcclusionBuffer::NearPlane)
+	{
+		return false;
+	}
+
+	const float Scale = PixelScale / OutDepth;
+	OutPixel = FVector2f(
+		Width * 0.5f + FVector3f::DotProduct(Point, ViewRight) * Scale,
+		Height * 0.5f - FVector3f::DotProduct(Point, ViewUp) * Scale
+	);
+	return true;
+}
+
+void FTargetSystemOcclusionBuffer::RasterizeBox(const FVector3f& Center, const FVector3f (&Axes)[3], const FVector3f& Extent)
+{
+	TArray<FVector2f, TInlineAllocator<8>> Corners;
+	float MaxDepth = 0.0f;
+	for (int32 CornerIndex = 0; CornerIndex < 8; ++CornerIndex)
+	{
+		const FVector3f Corner = Center
+			+ Axes[0] * (CornerIndex & 1 ? Extent.X : -Extent.X)
+			+ Axes[1] * (CornerIndex & 2 ? Extent.Y : -Extent.Y)
+			+ Axes[2] * (CornerIndex & 4 ? Extent.Z : -Extent.Z);
+
+		FVector2f Pixel;
+		float Depth;
+		if (!Project(Corner, Pixel, Depth))
+		{
+			return;
+		}
+
+		Corners.Add(Pixel);
+		MaxDepth = FMath::Max(MaxDepth, Depth);
+	}
+
+	// Whatever part of the box a pixel within its silhouette sees, it is nearer than the farthest corner
+	TargetSystemOcclusionBuffer::FPolygon Hull;
+	TargetSystemOcclusionBuffer::ComputeConvexHull(Corners, Hull);
+	if (Hull.Num() >= 3)
+	{
+		FillConvexPolygon(Hull, MaxDepth);
+	}
+}
+
+void FTargetSystemOcclusionBuffer::FillConvexPolygon(const TArrayView<const FVector2f> Hull, const float Depth)
+{
+	float MinY = TNumericLimits<float>::Max();
+	float MaxY = TNumericLimits<float>::Lowest();
+	for (const FVector2f& Point : Hull)
+	{
+		MinY = FMath::Min(MinY, Point.Y);
+		MaxY = FMath::Max(MaxY, Point.Y);
+	}
+
+	// Pixel (Column, Row) covers [Column, Column + 1] x [Row, Row + 1], and is only filled when its four corners are
+	// within the polygon, convexity then guaranteeing the whole pixel is
+	const int32 StartRow = FMath::Max(FMath::CeilToInt(MinY), 0);
+	const int32 EndRow = FMath::Min(FMath::FloorToInt(MaxY) - 1, Height - 1);
+	for (int32 Row = StartRow; Row <= EndRow; ++Row)
+	{
+		float TopMinX, TopMaxX, BottomMinX, BottomMaxX;
+		if (!TargetSystemOcclusionBuffer::GetPolygonSpan(Hull, Row, TopMinX, TopMaxX) || !TargetSystemOcclusionBuffer::GetPolygonSpan(Hull, Row + 1, BottomMinX, BottomMaxX))
+		{
+			continue;
+		}
+
+		const int32 StartColumn = FMath::Max(FMath::CeilToInt(FMath::Max(TopMinX, BottomMinX)), 0);
+		const int32 EndColumn = FMath::Min(FMath::FloorToInt(FMath::Min(TopMaxX, BottomMaxX)) - 1, Width - 1);
+
+		// Branch free span, for the compiler to vectorize it
+		float* RowDepths = Depths.GetData() + Row * Width;
+		for (int32 Column = StartColumn; Column <= EndColumn; ++Column)
+		{
+			RowDepths[Column] = FMath::Min(RowDepths[Column], Depth);
+		}
+	}
+}
+
+bool FTargetSystemOcclusionBuffer::IsRelativeSphereOccluded(const FVector3f& Center, const float Radius) const
+{
+	const float CenterDepth = FVector3f::DotProduct(Center, ViewForward);
+	const float NearDepth = CenterDepth - Radius;
+	const float FarDepth = CenterDepth + Radius;
+	if (NearDepth < TargetSystemOcclusionBuffer::NearPlane)
+	{
+		return false;
+	}
+
+	// Screen rect of the view aligned cube around the sphere: each side projects furthest out from its near or far face,
+	// depending on which side of the view axis it is
+	const float X = FVector3f::DotProduct(Center, ViewRight);
+	const float Y = FVector3f::DotProduct(Center, ViewUp);
+	const float MinRatioX = (X - Radius) / (X - Radius < 0.0f ? NearDepth : FarDepth);
+	const float MaxRatioX = (X + Radius) / (X + Radius > 0.0f ? NearDepth : FarDepth);
+	const float MinRatioY = (Y - Radius) / (Y - Radius < 0.0f ? NearDepth : FarDepth);
+	const float MaxRatioY = (Y + Radius) / (Y + Radius > 0.0f ? NearDepth : FarDepth);
+
+	const int32 StartColumn = FMath::FloorToInt(Width * 0.5f + MinRatioX * PixelScale);
+	const int32 EndColumn = FMath::FloorToInt(Width * 0.5f + MaxRatioX * PixelScale);
+	const int32 StartRow = FMath::FloorToInt(Height * 0.5f - MaxRatioY * PixelScale);
+	const int32 EndRow = FMath::FloorToInt(Height * 0.5f - MinRatioY * PixelScale);
+
+	// Nothing is known about what's outside of the buffer
+	if (StartColumn < 0 || StartRow < 0 || EndColumn >= Width || EndRow >= Height)
+	{
+		return false;
+	}
+
+	for (int32 Row = StartRow; Row <= EndRow; ++Row)
+	{
+		// Max reduction over the row, for the compiler to vectorize it
+		const float* RowDepths = Depths.GetData() + Row * Width;
+		float RowMaxDepth = 0.0f;
+		for (int32 Column = StartColumn; Column <= EndColumn; ++Column)
+		{
+			RowMaxDepth = FMath::Max(RowMaxDepth, RowDepths[Column]);
+		}
+
+		if (RowMaxDepth >= NearDepth)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,11 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemPreset.h"
+#include "Blueprint/UserWidget.h"
+#include "GameFramework/Pawn.h"
+
+UTargetSystemPreset::UTargetSystemPreset()
+{
+	Settings.LockedOnWidgetClass = TSoftClassPtr<UUserWidget>(FSoftObjectPath(TEXT("/TargetSystem/UI/WBP_LockOn.WBP_LockOn_C")));
+	Settings.TargetableActors = APawn::StaticClass();
+}
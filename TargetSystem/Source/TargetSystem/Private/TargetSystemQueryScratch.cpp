@@ -0,0 +1,47 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemQueryScratch.h"
+#include "TargetSystemStats.h"
+
+void FTargetSystemQueryScratch::Reset()
+{
+	Candidates.Reset();
+	VisibleCandidates.Reset();
+	CandidatesInRange.Reset();
+	DistancesSquared.Reset();
+	RelativeDistancesSquared.Reset();
+	Angles.Reset();
+	ScreenLocations.Reset();
+	ScreenDistances.Reset();
+	ActorsToIgnore.Reset();
+}
+
+SIZE_T FTargetSystemQueryScratch::GetAllocatedSize() const
+{
+	return Candidates.GetAllocatedSize()
+		+ VisibleCandidates.GetAllocatedSize()
+		+ CandidatesInRange.GetAllocatedSize()
+		+ DistancesSquared.GetAllocatedSize()
+		+ RelativeDistancesSquared.GetAllocatedSize()
+		+ Angles.GetAllocatedSize()
+		+ ScreenLocations.GetAllocatedSize()
+		+ ScreenDistances.GetAllocatedSize()
+		+ ActorsToIgnore.GetAllocatedSize();
+}
+
+FTargetSystemQueryScratchScope::FTargetSystemQueryScratchScope(FTargetSystemQueryScratch& InScratch)
+	: Scratch(InScratch)
+{
+	Scratch.Reset();
+	AllocatedSize = Scratch.GetAllocatedSize();
+	INC_DWORD_STAT(STAT_TargetSystemQueries);
+}
+
+FTargetSystemQueryScratchScope::~FTargetSystemQueryScratchScope()
+{
+	if (Scratch.GetAllocatedSize() != AllocatedSize)
+	{
+		++Scratch.NumGrowths;
+		INC_DWORD_STAT(STAT_TargetSystemScratchGrowths);
+	}
+}
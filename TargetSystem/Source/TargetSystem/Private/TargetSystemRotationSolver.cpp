@@ -0,0 +1,47 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemRotationSolver.h"
+
+void FTargetSystemRotationSolver::Reset()
+{
+	PitchVelocity = 0.0f;
+	YawVelocity = 0.0f;
+}
+
+FRotator FTargetSystemRotationSolver::Step(const FRotator& Current, const FRotator& Target, const float HalfLife, const float DeltaTime)
+{
+	return FRotator(
+		StepAxis(Current.Pitch, PitchVelocity, Target.Pitch, HalfLife, DeltaTime),
+		StepAxis(Current.Yaw, YawVelocity, Target.Yaw, HalfLife, DeltaTime),
+		Current.Roll
+	);
+}
+
+float FTargetSystemRotationSolver::StepAxis(const float Value, float& InOutVelocity, const float Goal, const float HalfLife, const float DeltaTime)
+{
+	// Shortest signed distance to the goal, so that we never spin the long way around the -180 / 180 boundary
+	const float Delta = FRotator::NormalizeAxis(Goal - Value);
+
+	if (HalfLife <= 0.0f)
+	{
+		InOutVelocity = 0.0f;
+		return FRotator::NormalizeAxis(Value + Delta);
+	}
+
+	if (DeltaTime <= 0.0f)
+	{
+		return Value;
+	}
+
+	// Critically damped spring, solved in the goal frame (x - goal). See "Spring-It-On", Daniel Holden.
+	// Half of the damping, with damping = 4 * ln(2) / HalfLife
+	const float Y = (2.0f * 0.69314718f) / HalfLife;
+	const float J0 = -Delta;
+	const float J1 = InOutVelocity + J0 * Y;
+	const float EYDT = FMath::Exp(-Y * DeltaTime);
+
+	const float NewOffset = EYDT * (J0 + J1 * DeltaTime);
+	InOutVelocity = EYDT * (InOutVelocity - J1 * Y * DeltaTime);
+
+	return FRotator::NormalizeAxis(Value + Delta + NewOffset);
+}
@@ -0,0 +1,18 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemStats.h"
+
+DEFINE_STAT(STAT_TargetSystemQueries);
+DEFINE_STAT(STAT_TargetSystemScratchGrowths);
+DEFINE_STAT(STAT_TargetSystemGatherCacheHits);
+DEFINE_STAT(STAT_TargetSystemGatherCacheMisses);
+DEFINE_STAT(STAT_TargetSystemLineOfSightCacheHits);
+DEFINE_STAT(STAT_TargetSystemLineOfSightCacheMisses);
+DEFINE_STAT(STAT_TargetSystemAimAssist);
+DEFINE_STAT(STAT_TargetSystemAimAssistTraces);
+DEFINE_STAT(STAT_TargetSystemOccluderRejections);
+DEFINE_STAT(STAT_TargetSystemOcclusionBuffer);
+DEFINE_STAT(STAT_TargetSystemOcclusionBufferRejections);
+DEFINE_STAT(STAT_TargetSystemOcclusionBufferCacheHits);
+DEFINE_STAT(STAT_TargetSystemOcclusionBufferCacheMisses);
+DEFINE_STAT(STAT_TargetSystemStaticVisibilityClear);
@@ -0,0 +1,1305 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemSubsystem.h"
+#include "EngineUtils.h"
+#include "GameplayTagAssetInterface.h"
+#include "TargetSystemLog.h"
+#include "TargetSystemOccluderComponent.h"
+#include "TargetSystemStats.h"
+#include "TargetSystemTargetableInterface.h"
+#include "Components/MeshComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarTargetSystemQueryCacheCellSize(
+	TEXT("TargetSystem.QueryCacheCellSize"),
+	50.0f,
+	TEXT("Size of the cells query origins are snapped to, for components querying from the same cell in the same frame to share\n")
+	TEXT("gathered candidates and line of sight traces. Kept below a pawn diameter, for a pawn not to block the traces of another one\n")
+	TEXT("sharing its cell. 0 to disable the query cache."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<int32> CVarTargetSystemOcclusionBufferWidth(
+	TEXT("TargetSystem.OcclusionBufferWidth"),
+	128,
+	TEXT("Width in pixels of the occlusion buffers of components using bUseOcclusionBuffer, the height following the view aspect ratio."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<bool> CVarTargetSystemUseOccluders(
+	TEXT("TargetSystem.UseOccluders"),
+	true,
+	TEXT("Whether line of sight traces are tested against occluder components first, and rejected without a physics query\n")
+	TEXT("when crossing one."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<bool> CVarTargetSystemUseStaticVisibility(
+	TEXT("TargetSystem.UseStaticVisibility"),
+	true,
+	TEXT("Whether line of sight traces use the static visibility baked by visibility volumes, only tracing dynamic objects between\n")
+	TEXT("cells static geometry never blocks."),
+	ECVF_Default
+);
+
+namespace TargetSystemSubsystem
+{
+	// Maximum number of actors of streamed in levels checked for registration per frame.
+	static constexpr int32 LevelRegistrationBudget = 256;
+
+	// Speed partition bounds are padded with for targets at rest as of the last refresh, which may have started moving since.
+	static constexpr float PartitionBoundsMinSpeed = 1000.0f;
+
+	// Weight of the latest result in the moving average of visibility point scores.
+	static constexpr float VisibilityPointScoreRate = 0.25f;
+
+	static bool ResolveSocket(const UMeshComponent* MeshComponent, const FName SocketName, FTargetSystemResolvedSocket& OutSocket)
+	{
+		OutSocket = FTargetSystemResolvedSocket();
+		if (!MeshComponent || !MeshComponent->DoesSocketExist(SocketName))
+		{
+			return false;
+		}
+
+		if (const USkinnedMeshComponent* SkinnedMesh = Cast<USkinnedMeshComponent>(MeshComponent))
+		{
+			// Bones move with animation: only resolve the bone, and the socket offset from it, once
+			const USkeletalMeshSocket* Socket = SkinnedMesh->GetSocketByName(SocketName);
+			OutSocket.BoneIndex = SkinnedMesh->GetBoneIndex(Socket ? Socket->BoneName : SocketName);
+			OutSocket.Transform = Socket ? Socket->GetSocketLocalTransform() : FTransform::Identity;
+			if (OutSocket.BoneIndex == INDEX_NONE)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Static sockets never move relative to their component
+			OutSocket.Transform = MeshComponent->GetSocketTransform(SocketName, RTS_Component);
+		}
+
+		OutSocket.bValid = true;
+		return true;
+	}
+
+	static bool GetSocketLocation(const USceneComponent* Component, const FTargetSystemResolvedSocket& Socket, FVector& OutLocation)
+	{
+		if (!Component || !Socket.bValid)
+		{
+			return false;
+		}
+
+		FVector ComponentSpaceLocation = Socket.Transform.GetLocation();
+		if (Socket.BoneIndex != INDEX_NONE)
+		{
+			// Read back the last evaluated pose, instead of looking the socket up by name again with GetSocketTransform
+			const TArray<FTransform>& ComponentSpaceTransforms = static_cast<const USkinnedMeshComponent*>(Component)->GetComponentSpaceTransforms();
+			if (!ComponentSpaceTransforms.IsValidIndex(Socket.BoneIndex))
+			{
+				return false;
+			}
+
+			ComponentSpaceLocation = ComponentSpaceTransforms[Socket.BoneIndex].TransformPosition(ComponentSpaceLocation);
+		}
+
+		OutLocation = Component->GetComponentTransform().TransformPosition(ComponentSpaceLocation);
+		return true;
+	}
+}
+
+void UTargetSystemSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTargetSystemSubsystem::OnActorSpawned));
+	ActorDestroyedHandle = World->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UTargetSystemSubsystem::OnActorDestroyed));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UTargetSystemSubsystem::OnLevelAddedToWorld);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UTargetSystemSubsystem::OnLevelRemovedFromWorld);
+	TargetabilityChangedHandle = ITargetSystemTargetableInterface::OnTargetabilityChanged().AddUObject(this, &UTargetSystemSubsystem::OnTargetabilityChanged);
+	GameplayTagsChangedHandle = ITargetSystemTargetableInterface::OnGameplayTagsChanged().AddUObject(this, &UTargetSystemSubsystem::OnGameplayTagsChanged);
+}
+
+void UTargetSystemSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		World->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+	}
+
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	ITargetSystemTargetableInterface::OnTargetabilityChanged().Remove(TargetabilityChangedHandle);
+	ITargetSystemTargetableInterface::OnGameplayTagsChanged().Remove(GameplayTagsChangedHandle);
+
+	Partitions.Reset();
+	PartitionIndices.Reset();
+	PendingLevels.Reset();
+	TargetableClasses.Reset();
+	TargetableClassAimSockets.Reset();
+	IgnoredAimSockets.Reset();
+	DispatchCache.Reset();
+	TargetingDataDispatchCache.Reset();
+	IndexedTags.Reset();
+	TagIndices.Reset();
+	GatherCache.Reset();
+	GatherSnapshotPool.Reset();
+	LineOfSightCache.Reset();
+	OcclusionBufferCache.Reset();
+	OccluderComponents.Reset();
+	Occluders.Reset(FVector::ZeroVector);
+	StaticVisibilityData.Reset();
+	VisibilityPointSets.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UTargetSystemSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TSharedRef<const FTargetSystemCandidateSnapshot> UTargetSystemSubsystem::GatherCandidates(const FVector& Origin, const float Radius)
+{
+	UpdateRegistry();
+
+	FIntVector Cell;
+	const bool bCacheable = GetQueryCacheCell(Origin, Cell);
+
+	// Shared snapshots cover the whole cell: pad the radius with its half diagonal, and rebase on its center
+	const float CellSize = CVarTargetSystemQueryCacheCellSize.GetValueOnGameThread();
+	const FVector QueryOrigin = bCacheable ? (FVector(Cell) + 0.5f) * CellSize : Origin;
+	const float QueryRadius = bCacheable ? Radius + CellSize * UE_HALF_SQRT_3 : Radius;
+
+	// Before looking the cache up, registering targets clears it
+	RegisterPendingLevels(QueryOrigin, QueryRadius);
+	UpdateQueryCache();
+
+	if (bCacheable)
+	{
+		for (const FGatherCacheEntry& Entry : GatherCache)
+		{
+			if (Entry.Cell == Cell && Entry.Radius == Radius)
+			{
+				++QueryCacheStats.GatherHits;
+				INC_DWORD_STAT(STAT_TargetSystemGatherCacheHits);
+				return Entry.Snapshot.ToSharedRef();
+			}
+		}
+
+		++QueryCacheStats.GatherMisses;
+		INC_DWORD_STAT(STAT_TargetSystemGatherCacheMisses);
+	}
+
+	const TSharedPtr<FTargetSystemCandidateSnapshot> Snapshot = AllocateGatherSnapshot();
+	const double Time = GetWorld()->GetTimeSeconds();
+	for (FTargetSystemPartition& Partition : Partitions)
+	{
+		// Targets may have moved since the last refresh, at most as fast as the fastest of them then
+		const float Speed = FMath::Max(Partition.MaxTargetSpeed, TargetSystemSubsystem::PartitionBoundsMinSpeed);
+		const float PaddedRadius = QueryRadius + Speed * static_cast<float>(Time - Partition.BoundsTime);
+		if (!Partition.Bounds.IsValid || Partition.Bounds.ComputeSquaredDistanceToPoint(QueryOrigin) > FMath::Square(PaddedRadius))
+		{
+			continue;
+		}
+
+		Snapshot->Append(GetPartitionSnapshot(Partition));
+	}
+
+	// Distances and angles are computed relative to the query origin, at float precision
+	Snapshot->Rebase(QueryOrigin);
+	Snapshot->FrameNumber = GFrameCounter;
+	Snapshot->Revision = Revision;
+
+	if (bCacheable)
+	{
+		GatherCache.Add({ Cell, Radius, Snapshot });
+	}
+
+	return Snapshot.ToSharedRef();
+}
+
+bool UTargetSystemSubsystem::FindCachedLineOfSight(const FVector& Origin, const AActor* Target, const AActor* IgnoredActor, const ECollisionChannel TraceChannel, const int32 VisibilityPointSet, bool& bOutVisible)
+{
+	UpdateQueryCache();
+
+	FIntVector Cell;
+	if (!GetQueryCacheCell(Origin, Cell))
+	{
+		return false;
+	}
+
+	if (const bool* bVisible = LineOfSightCache.Find({ Cell, FObjectKey(Target), FObjectKey(IgnoredActor), TraceChannel, VisibilityPointSet }))
+	{
+		++QueryCacheStats.LineOfSightHits;
+		INC_DWORD_STAT(STAT_TargetSystemLineOfSightCacheHits);
+		bOutVisible = *bVisible;
+		return true;
+	}
+
+	++QueryCacheStats.LineOfSightMisses;
+	INC_DWORD_STAT(STAT_TargetSystemLineOfSightCacheMisses);
+	return false;
+}
+
+void UTargetSystemSubsystem::AddCachedLineOfSight(const FVector& Origin, const AActor* Target, const AActor* IgnoredActor, const ECollisionChannel TraceChannel, const int32 VisibilityPointSet, const bool bVisible)
+{
+	FIntVector Cell;
+	if (GetQueryCacheCell(Origin, Cell))
+	{
+		LineOfSightCache.Add({ Cell, FObjectKey(Target), FObjectKey(IgnoredActor), TraceChannel, VisibilityPointSet }, bVisible);
+	}
+}
+
+int32 UTargetSystemSubsystem::RegisterVisibilityPointSet(const FTargetSystemVisibilityPointSet& PointSet)
+{
+	const int32 Set = VisibilityPointSets.IndexOfByKey(PointSet);
+	return Set != INDEX_NONE ? Set : VisibilityPointSets.Add(PointSet);
+}
+
+void UTargetSystemSubsystem::GetVisibilityPoints(const AActor* Target, const int32 Set, const FVector& AimPoint, TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>>& OutPoints)
+{
+	OutPoints.Reset();
+	OutPoints.Add({ 0, AimPoint });
+
+	if (!Target || !VisibilityPointSets.IsValidIndex(Set) || VisibilityPointSets[Set].GetNumPoints() == 1)
+	{
+		return;
+	}
+
+	const FTargetSystemVisibilityPointSet& PointSet = VisibilityPointSets[Set];
+
+	// Sockets can only be resolved once for registered targets, others are only tested from their aim point and bounds
+	FTargetSystemTarget* RegisteredTarget = FindTarget(Target);
+	FTargetSystemTargetVisibilityPoints* Points = RegisteredTarget ? &FindOrAddVisibilityPoints(*RegisteredTarget, Set) : nullptr;
+	if (Points)
+	{
+		if (!Points->bSocketsResolved)
+		{
+			ResolveVisibilitySockets(*Points, Target);
+		}
+
+		const USceneComponent* SocketComponent = Points->SocketComponent.Get();
+		for (int32 SocketIndex = 0; SocketIndex < Points->Sockets.Num(); ++SocketIndex)
+		{
+			FVector Location;
+			if (TargetSystemSubsystem::GetSocketLocation(SocketComponent, Points->Sockets[SocketIndex], Location))
+			{
+				OutPoints.Add({ 1 + SocketIndex, Location });
+			}
+		}
+	}
+
+	const USceneComponent* RootComponent = Target->GetRootComponent();
+	if (PointSet.bTestBoundsCorners && RootComponent)
+	{
+		// One bit per axis, picking the positive or negative side of the bounds
+		const int32 FirstCornerIndex = 1 + PointSet.Sockets.Num();
+		const FVector Extent = RootComponent->Bounds.BoxExtent * PointSet.BoundsCornersScale;
+		for (int32 CornerIndex = 0; CornerIndex < 8; ++CornerIndex)
+		{
+			OutPoints.Add({ FirstCornerIndex + CornerIndex, RootComponent->Bounds.Origin + FVector(
+				CornerIndex & 1 ? Extent.X : -Extent.X,
+				CornerIndex & 2 ? Extent.Y : -Extent.Y,
+				CornerIndex & 4 ? Extent.Z : -Extent.Z
+			) });
+		}
+	}
+
+	if (!Points || Points->Scores.Num() == 0)
+	{
+		return;
+	}
+
+	// Stable, for points with the same score to keep their set order
+	const TArray<float, TInlineAllocator<4>>& Scores = Points->Scores;
+	OutPoints.StableSort([&Scores](const FTargetSystemVisibilityPoint& A, const FTargetSystemVisibilityPoint& B)
+	{
+		return Scores[A.Index] > Scores[B.Index];
+	});
+}
+
+void UTargetSystemSubsystem::ReportVisibilityPoint(const AActor* Target, const int32 Set, const int32 PointIndex, const bool bVisible)
+{
+	if (!VisibilityPointSets.IsValidIndex(Set) || VisibilityPointSets[Set].GetNumPoints() == 1)
+	{
+		return;
+	}
+
+	FTargetSystemTarget* RegisteredTarget = FindTarget(Target);
+	if (!RegisteredTarget)
+	{
+		return;
+	}
+
+	TArray<float, TInlineAllocator<4>>& Scores = FindOrAddVisibilityPoints(*RegisteredTarget, Set).Scores;
+	if (Scores.Num() == 0)
+	{
+		// Start with the aim point first, the other points in their set order
+		Scores.Init(0.5f, VisibilityPointSets[Set].GetNumPoints());
+		Scores[0] = 1.0f;
+	}
+
+	if (Scores.IsValidIndex(PointIndex))
+	{
+		Scores[PointIndex] += ((bVisible ? 1.0f : 0.0f) - Scores[PointIndex]) * TargetSystemSubsystem::VisibilityPointScoreRate;
+	}
+}
+
+void UTargetSystemSubsystem::RegisterOccluder(UTargetSystemOccluderComponent* Occluder)
+{
+	OccluderComponents.AddUnique(Occluder);
+	bOccludersDirty = true;
+}
+
+void UTargetSystemSubsystem::UnregisterOccluder(UTargetSystemOccluderComponent* Occluder)
+{
+	OccluderComponents.RemoveSingleSwap(Occluder);
+	bOccludersDirty = true;
+}
+
+bool UTargetSystemSubsystem::IsOccluded(const FVector& Start, const FVector& End)
+{
+	if (OccluderComponents.Num() == 0 || !CVarTargetSystemUseOccluders.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	if (bOccludersDirty)
+	{
+		RebuildOccluders();
+	}
+
+	if (!Occluders.IsSegmentBlocked(Start, End))
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_TargetSystemOccluderRejections);
+	return true;
+}
+
+const FTargetSystemOccluderSet& UTargetSystemSubsystem::GetOccluders()
+{
+	if (bOccludersDirty)
+	{
+		RebuildOccluders();
+	}
+
+	return Occluders;
+}
+
+const FTargetSystemOcclusionBuffer& UTargetSystemSubsystem::GetOcclusionBuffer(const FVector& ViewLocation, const FRotator& ViewRotation, const float FOVDegrees, const float AspectRatio)
+{
+	const FTargetSystemOccluderSet& CurrentOccluders = GetOccluders();
+	const int32 Width = CVarTargetSystemOcclusionBufferWidth.GetValueOnGameThread();
+
+	// Exact views only, a buffer rasterized from a nearby view would not be conservative anymore
+	FOcclusionBufferEntry* OutdatedEntry = nullptr;
+	for (FOcclusionBufferEntry& Entry : OcclusionBufferCache)
+	{
+		if (Entry.Buffer.FrameNumber != GFrameCounter)
+		{
+			OutdatedEntry = OutdatedEntry ? OutdatedEntry : &Entry;
+		}
+		else if (Entry.ViewLocation == ViewLocation && Entry.ViewRotation == ViewRotation && Entry.FOVDegrees == FOVDegrees
+			&& Entry.AspectRatio == AspectRatio && Entry.Width == Width)
+		{
+			++QueryCacheStats.OcclusionBufferHits;
+			INC_DWORD_STAT(STAT_TargetSystemOcclusionBufferCacheHits);
+			return Entry.Buffer;
+		}
+	}
+
+	++QueryCacheStats.OcclusionBufferMisses;
+	INC_DWORD_STAT(STAT_TargetSystemOcclusionBufferCacheMisses);
+
+	FOcclusionBufferEntry& Entry = OutdatedEntry ? *OutdatedEntry : OcclusionBufferCache.AddDefaulted_GetRef();
+	Entry.ViewLocation = ViewLocation;
+	Entry.ViewRotation = ViewRotation;
+	Entry.FOVDegrees = FOVDegrees;
+	Entry.AspectRatio = AspectRatio;
+	Entry.Width = Width;
+	Entry.Buffer.FrameNumber = GFrameCounter;
+	Entry.Buffer.Init(ViewLocation, ViewRotation, FOVDegrees, AspectRatio, Width);
+	Entry.Buffer.RasterizeOccluders(CurrentOccluders);
+	return Entry.Buffer;
+}
+
+void UTargetSystemSubsystem::RebuildOccluders()
+{
+	bOccludersDirty = false;
+
+	// Store shapes relative to the center of the occluders, for float precision to hold in large worlds
+	FBox Bounds(ForceInit);
+	for (const TWeakObjectPtr<UTargetSystemOccluderComponent>& Occluder : OccluderComponents)
+	{
+		if (Occluder.IsValid())
+		{
+			Bounds += Occluder->GetComponentLocation();
+		}
+	}
+
+	Occluders.Reset(Bounds.IsValid ? Bounds.GetCenter() : FVector::ZeroVector);
+	for (const TWeakObjectPtr<UTargetSystemOccluderComponent>& Occluder : OccluderComponents)
+	{
+		if (Occluder.IsValid())
+		{
+			Occluder->AddTo(Occluders);
+		}
+	}
+
+	// Buffers rasterized from the previous shapes are outdated
+	for (FOcclusionBufferEntry& Entry : OcclusionBufferCache)
+	{
+		Entry.Buffer.FrameNumber = 0;
+	}
+}
+
+void UTargetSystemSubsystem::AddStaticVisibility(const UTargetSystemVisibilityData* VisibilityData)
+{
+	if (VisibilityData)
+	{
+		StaticVisibilityData.AddUnique(VisibilityData);
+	}
+}
+
+void UTargetSystemSubsystem::RemoveStaticVisibility(const UTargetSystemVisibilityData* VisibilityData)
+{
+	StaticVisibilityData.RemoveSingleSwap(VisibilityData);
+}
+
+bool UTargetSystemSubsystem::IsStaticallyClear(const FVector& Start, const FVector& End, const ECollisionChannel TraceChannel) const
+{
+	if (StaticVisibilityData.Num() == 0 || !CVarTargetSystemUseStaticVisibility.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	for (const TWeakObjectPtr<const UTargetSystemVisibilityData>& VisibilityData : StaticVisibilityData)
+	{
+		if (VisibilityData.IsValid() && VisibilityData->TraceChannel == TraceChannel && VisibilityData->IsStaticallyClear(Start, End))
+		{
+			INC_DWORD_STAT(STAT_TargetSystemStaticVisibilityClear);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UTargetSystemSubsystem::UpdateQueryCache()
+{
+	if (QueryCacheFrameNumber == GFrameCounter && QueryCacheRevision == Revision)
+	{
+		return;
+	}
+
+	QueryCacheFrameNumber = GFrameCounter;
+	QueryCacheRevision = Revision;
+
+	for (FGatherCacheEntry& Entry : GatherCache)
+	{
+		GatherSnapshotPool.Add(MoveTemp(Entry.Snapshot));
+	}
+
+	GatherCache.Reset();
+	LineOfSightCache.Reset();
+}
+
+TSharedPtr<FTargetSystemCandidateSnapshot> UTargetSystemSubsystem::AllocateGatherSnapshot()
+{
+	// Snapshots still held by a component are dropped from the pool, the component owns them from now on
+	while (GatherSnapshotPool.Num() > 0)
+	{
+		TSharedPtr<FTargetSystemCandidateSnapshot> Snapshot = GatherSnapshotPool.Pop();
+		if (Snapshot.GetSharedReferenceCount() == 1)
+		{
+			Snapshot->Reset(Snapshot->Num());
+			return Snapshot;
+		}
+	}
+
+	return MakeShared<FTargetSystemCandidateSnapshot>();
+}
+
+bool UTargetSystemSubsystem::GetQueryCacheCell(const FVector& Location, FIntVector& OutCell)
+{
+	const float CellSize = CVarTargetSystemQueryCacheCellSize.GetValueOnGameThread();
+	if (CellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	OutCell = FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize)
+	);
+	return true;
+}
+
+void UTargetSystemSubsystem::GetTargetingData(const AActor* Actor, FTargetSystemTargetingData& OutTargetingData)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	if (FTargetSystemPartition* Partition = FindPartition(Actor))
+	{
+		// Take the snapshot first, it may prune stale entries and move indices around
+		const FTargetSystemCandidateSnapshot& Snapshot = GetPartitionSnapshot(*Partition);
+		if (const int32* Index = Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)))
+		{
+			OutTargetingData = Snapshot.GetTargetingData(*Index);
+			return;
+		}
+	}
+
+	FTargetSystemTarget Target;
+	Target.TargetingDataDispatch = GetTargetingDataDispatch(Actor->GetClass());
+	Target.NativeInterface = Cast<ITargetSystemTargetableInterface>(Actor);
+	OutTargetingData = GetTargetingData(Target, Actor);
+}
+
+const FTargetSystemCandidateSnapshot& UTargetSystemSubsystem::GetPartitionSnapshot(FTargetSystemPartition& Partition)
+{
+	if (Partition.bSnapshotDirty || Partition.Snapshot.FrameNumber != GFrameCounter)
+	{
+		TakePartitionSnapshot(Partition);
+	}
+
+	return Partition.Snapshot;
+}
+
+void UTargetSystemSubsystem::TakePartitionSnapshot(FTargetSystemPartition& Partition)
+{
+	// Prune stale entries (actors removed without being destroyed) first, so that snapshot indices match registry ones
+	for (int32 Index = Partition.Targets.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Partition.Targets[Index].Actor.IsValid())
+		{
+			RemoveTargetAt(Partition, Index);
+		}
+	}
+
+	if (Partition.bTargetTagsDirty)
+	{
+		for (FTargetSystemTarget& Target : Partition.Targets)
+		{
+			MirrorTargetTags(Target);
+		}
+
+		Partition.bTargetTagsDirty = false;
+	}
+
+	FTargetSystemCandidateSnapshot& Snapshot = Partition.Snapshot;
+	Snapshot.Reset(Partition.Targets.Num());
+	for (FTargetSystemTarget& Target : Partition.Targets)
+	{
+		AActor* Actor = Target.Actor.Get();
+		Snapshot.Add(Actor, GetTargetingData(Target, Actor), IsTargetable(Target, Actor), Target.TagBits, Actor->GetLastRenderTime());
+	}
+
+	// Fresh aim points are at hand, refresh the bounds for free
+	float MaxSpeedSquared = 0.0f;
+	Partition.Bounds = FBox(ForceInit);
+	for (int32 Index = 0; Index < Snapshot.Num(); ++Index)
+	{
+		Partition.Bounds += FBox::BuildAABB(Snapshot.AimPoints[Index], FVector(Snapshot.BoundingRadii[Index]));
+		MaxSpeedSquared = FMath::Max(MaxSpeedSquared, static_cast<float>(Snapshot.Actors[Index]->GetVelocity().SizeSquared()));
+	}
+
+	Partition.BoundsTime = GetWorld()->GetTimeSeconds();
+	Partition.MaxTargetSpeed = FMath::Sqrt(MaxSpeedSquared);
+
+	Snapshot.FrameNumber = GFrameCounter;
+	Snapshot.Revision = Revision;
+	Partition.bSnapshotDirty = false;
+}
+
+bool UTargetSystemSubsystem::IsTargetable(const AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return false;
+	}
+
+	if (FTargetSystemPartition* Partition = FindPartition(Actor))
+	{
+		const FTargetSystemCandidateSnapshot& Snapshot = GetPartitionSnapshot(*Partition);
+		if (const int32* Index = Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)))
+		{
+			return Snapshot.Targetable[*Index];
+		}
+	}
+
+	FTargetSystemTarget Target;
+	Target.Dispatch = GetTargetableDispatch(Actor->GetClass());
+	Target.NativeInterface = Cast<ITargetSystemTargetableInterface>(Actor);
+	return IsTargetable(Target, Actor);
+}
+
+ETargetSystemTargetableDispatch UTargetSystemSubsystem::GetTargetableDispatch(const UClass* Class)
+{
+	if (const ETargetSystemTargetableDispatch* Dispatch = DispatchCache.Find(FObjectKey(Class)))
+	{
+		return *Dispatch;
+	}
+
+	ETargetSystemTargetableDispatch Dispatch = ETargetSystemTargetableDispatch::None;
+	if (Class->ImplementsInterface(UTargetSystemTargetableInterface::StaticClass()))
+	{
+		// Native implementers expose the interface through a C++ vtable, unless a Blueprint child overrides the event
+		const UFunction* Function = Class->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(ITargetSystemTargetableInterface, IsTargetable));
+		const bool bImplementedInScript = Function && !Function->HasAnyFunctionFlags(FUNC_Native);
+		const bool bImplementedNatively = Class->GetDefaultObject()->GetNativeInterfaceAddress(UTargetSystemTargetableInterface::StaticClass()) != nullptr;
+
+		Dispatch = bImplementedNatively && !bImplementedInScript ? ETargetSystemTargetableDispatch::Native : ETargetSystemTargetableDispatch::Script;
+	}
+
+	DispatchCache.Add(FObjectKey(Class), Dispatch);
+	return Dispatch;
+}
+
+ETargetSystemTargetableDispatch UTargetSystemSubsystem::GetTargetingDataDispatch(const UClass* Class)
+{
+	if (const ETargetSystemTargetableDispatch* Dispatch = TargetingDataDispatchCache.Find(FObjectKey(Class)))
+	{
+		return *Dispatch;
+	}
+
+	// Unlike targetability, Blueprints not overriding the event keep the default targeting data rather than calling it
+	ETargetSystemTargetableDispatch Dispatch = ETargetSystemTargetableDispatch::None;
+	if (Class->ImplementsInterface(UTargetSystemTargetableInterface::StaticClass()))
+	{
+		const UFunction* Function = Class->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(ITargetSystemTargetableInterface, GetTargetingData));
+		const bool bImplementedInScript = Function && !Function->HasAnyFunctionFlags(FUNC_Native);
+		const bool bImplementedNatively = Class->GetDefaultObject()->GetNativeInterfaceAddress(UTargetSystemTargetableInterface::StaticClass()) != nullptr;
+
+		if (bImplementedInScript)
+		{
+			Dispatch = ETargetSystemTargetableDispatch::Script;
+		}
+		else if (bImplementedNatively)
+		{
+			Dispatch = ETargetSystemTargetableDispatch::Native;
+		}
+	}
+
+	TargetingDataDispatchCache.Add(FObjectKey(Class), Dispatch);
+	return Dispatch;
+}
+
+void UTargetSystemSubsystem::CompileTagQuery(const FGameplayTagQuery& Query, FTargetSystemCompiledTagQuery& OutCompiledQuery)
+{
+	OutCompiledQuery.Nodes.Reset();
+	OutCompiledQuery.UncompiledQuery.Reset();
+	if (Query.IsEmpty())
+	{
+		return;
+	}
+
+	FGameplayTagQueryExpression Expression;
+	Query.GetQueryExpr(Expression);
+
+	OutCompiledQuery.Nodes.AddDefaulted();
+	if (!CompileTagQueryExpression(Expression, 0, OutCompiledQuery))
+	{
+		TS_LOG(Warning, TEXT("UTargetSystemSubsystem::CompileTagQuery - Could not compile %s, matching it against owned tags instead"), *Query.GetDescription());
+		OutCompiledQuery.Nodes.Reset();
+		OutCompiledQuery.UncompiledQuery = Query;
+	}
+}
+
+int32 UTargetSystemSubsystem::GetOrAddTagIndex(const FGameplayTag& Tag)
+{
+	if (const int32* Index = TagIndices.Find(Tag))
+	{
+		return *Index;
+	}
+
+	if (IndexedTags.Num() >= TargetSystemMaxIndexedTags)
+	{
+		TS_LOG(Warning, TEXT("UTargetSystemSubsystem::GetOrAddTagIndex - Too many tags referenced by tag queries, %s can't be indexed"), *Tag.ToString());
+		return INDEX_NONE;
+	}
+
+	// Targets now need to know whether they own this new tag
+	for (FTargetSystemPartition& Partition : Partitions)
+	{
+		Partition.bTargetTagsDirty = true;
+		Partition.bSnapshotDirty = true;
+	}
+	++Revision;
+
+	TagIndices.Add(Tag, IndexedTags.Num());
+	return IndexedTags.Add(Tag);
+}
+
+bool UTargetSystemSubsystem::CompileTagQueryExpression(const FGameplayTagQueryExpression& Expression, const int32 NodeIndex, FTargetSystemCompiledTagQuery& OutCompiledQuery)
+{
+	OutCompiledQuery.Nodes[NodeIndex].Type = Expression.ExprType;
+
+	switch (Expression.ExprType)
+	{
+	case EGameplayTagQueryExprType::AnyTagsMatch:
+	case EGameplayTagQueryExprType::AllTagsMatch:
+	case EGameplayTagQueryExprType::NoTagsMatch:
+		for (const FGameplayTag& Tag : Expression.TagSet)
+		{
+			const int32 TagIndex = GetOrAddTagIndex(Tag);
+			if (TagIndex == INDEX_NONE)
+			{
+				return false;
+			}
+
+			OutCompiledQuery.Nodes[NodeIndex].Mask.SetBit(TagIndex);
+		}
+		return true;
+	case EGameplayTagQueryExprType::AnyExprMatch:
+	case EGameplayTagQueryExprType::AllExprMatch:
+	case EGameplayTagQueryExprType::NoExprMatch:
+		{
+			// Children are laid out contiguously, before any of their own children
+			const int32 FirstChild = OutCompiledQuery.Nodes.Num();
+			OutCompiledQuery.Nodes.AddDefaulted(Expression.ExprSet.Num());
+			OutCompiledQuery.Nodes[NodeIndex].FirstChild = FirstChild;
+			OutCompiledQuery.Nodes[NodeIndex].NumChildren = Expression.ExprSet.Num();
+
+			for (int32 Child = 0; Child < Expression.ExprSet.Num(); ++Child)
+			{
+				if (!CompileTagQueryExpression(Expression.ExprSet[Child], FirstChild + Child, OutCompiledQuery))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	default:
+		// Eg. exact matches, not mirrored in the tag bits
+		return false;
+	}
+}
+
+void UTargetSystemSubsystem::MirrorTargetTags(FTargetSystemTarget& Target) const
+{
+	Target.TagBits = FTargetSystemTagBits();
+	if (!Target.TagAssetInterface || IndexedTags.Num() == 0 || !Target.Actor.IsValid())
+	{
+		return;
+	}
+
+	FGameplayTagContainer OwnedTags;
+	Target.TagAssetInterface->GetOwnedGameplayTags(OwnedTags);
+
+	// HasTag matches parent tags as well, so that a query on A matches a target owning A.B
+	for (int32 TagIndex = 0; TagIndex < IndexedTags.Num(); ++TagIndex)
+	{
+		if (OwnedTags.HasTag(IndexedTags[TagIndex]))
+		{
+			Target.TagBits.SetBit(TagIndex);
+		}
+	}
+}
+
+void UTargetSystemSubsystem::RegisterTargetableClass(const TSubclassOf<AActor> ActorClass, const FName AimSocket)
+{
+	const int32 ClassIndex = TargetableClasses.Find(ActorClass);
+	if (ClassIndex != INDEX_NONE)
+	{
+		// Aim sockets are set per class, the first one registered is kept
+		const FName ClassAimSocket = TargetableClassAimSockets[ClassIndex];
+		if (AimSocket != NAME_None && ClassAimSocket == NAME_None)
+		{
+			TargetableClassAimSockets[ClassIndex] = AimSocket;
+			InvalidateAimSockets();
+		}
+		else if (AimSocket != NAME_None && AimSocket != ClassAimSocket)
+		{
+			bool bAlreadyIgnored = false;
+			IgnoredAimSockets.Add({ FObjectKey(ActorClass), AimSocket }, &bAlreadyIgnored);
+			if (!bAlreadyIgnored)
+			{
+				TS_LOG(Warning, TEXT("UTargetSystemSubsystem::RegisterTargetableClass - %s already aims at %s, %s will be ignored"), *GetNameSafe(ActorClass), *ClassAimSocket.ToString(), *AimSocket.ToString());
+			}
+		}
+
+		return;
+	}
+
+	TargetableClasses.Add(ActorClass);
+	TargetableClassAimSockets.Add(AimSocket);
+
+	// Targets registered for another class may be of this one as well
+	if (AimSocket != NAME_None)
+	{
+		InvalidateAimSockets();
+	}
+
+	// Only this one time, register already spawned actors. From now on they'll get registered as they're spawned or streamed in.
+	for (TActorIterator<AActor> ActorIterator(GetWorld(), ActorClass); ActorIterator; ++ActorIterator)
+	{
+		RegisterActor(*ActorIterator);
+	}
+}
+
+bool UTargetSystemSubsystem::IsRegisteredClass(const AActor* Actor) const
+{
+	for (const TSubclassOf<AActor>& TargetableClass : TargetableClasses)
+	{
+		if (Actor->IsA(TargetableClass))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UTargetSystemSubsystem::RegisterActor(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	FTargetSystemPartition& Partition = FindOrAddPartition(Actor->GetLevel());
+	const TObjectKey<AActor> Key(Actor);
+	if (Partition.TargetIndices.Contains(Key))
+	{
+		return;
+	}
+
+	FTargetSystemTarget& Target = Partition.Targets.AddDefaulted_GetRef();
+	Target.Actor = Actor;
+	Target.Key = Key;
+	Target.Dispatch = GetTargetableDispatch(Actor->GetClass());
+	Target.TargetingDataDispatch = GetTargetingDataDispatch(Actor->GetClass());
+	Target.NativeInterface = Cast<ITargetSystemTargetableInterface>(Actor);
+	Target.TagAssetInterface = Cast<IGameplayTagAssetInterface>(Actor);
+	MirrorTargetTags(Target);
+
+	Partition.TargetIndices.Add(Key, Partition.Targets.Num() - 1);
+	if (!Partition.Bounds.IsValid)
+	{
+		Partition.BoundsTime = GetWorld()->GetTimeSeconds();
+	}
+
+	Partition.Bounds += Actor->GetActorLocation();
+	Partition.MaxTargetSpeed = FMath::Max(Partition.MaxTargetSpeed, static_cast<float>(Actor->GetVelocity().Size()));
+	Partition.bSnapshotDirty = true;
+	++Revision;
+}
+
+void UTargetSystemSubsystem::UnregisterActor(const AActor* Actor)
+{
+	if (FTargetSystemPartition* Partition = FindPartition(Actor))
+	{
+		if (const int32* Index = Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)))
+		{
+			RemoveTargetAt(*Partition, *Index);
+		}
+	}
+}
+
+void UTargetSystemSubsystem::RemoveTargetAt(FTargetSystemPartition& Partition, const int32 Index)
+{
+	Partition.TargetIndices.Remove(Partition.Targets[Index].Key);
+	Partition.Targets.RemoveAtSwap(Index);
+	Partition.bSnapshotDirty = true;
+	++Revision;
+
+	// Fix up the index of the entry that was swapped in
+	if (Partition.Targets.IsValidIndex(Index))
+	{
+		Partition.TargetIndices.Add(Partition.Targets[Index].Key, Index);
+	}
+}
+
+FTargetSystemPartition* UTargetSystemSubsystem::FindPartition(const AActor* Actor)
+{
+	const int32* PartitionIndex = Actor ? PartitionIndices.Find(TObjectKey<ULevel>(Actor->GetLevel())) : nullptr;
+	return PartitionIndex ? &Partitions[*PartitionIndex] : nullptr;
+}
+
+FTargetSystemTarget* UTargetSystemSubsystem::FindTarget(const AActor* Actor)
+{
+	FTargetSystemPartition* Partition = FindPartition(Actor);
+	const int32* Index = Partition ? Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)) : nullptr;
+	return Index ? &Partition->Targets[*Index] : nullptr;
+}
+
+FTargetSystemPartition& UTargetSystemSubsystem::FindOrAddPartition(ULevel* Level)
+{
+	const TObjectKey<ULevel> Key(Level);
+	if (const int32* PartitionIndex = PartitionIndices.Find(Key))
+	{
+		return Partitions[*PartitionIndex];
+	}
+
+	const int32 PartitionIndex = Partitions.Add(FTargetSystemPartition());
+	PartitionIndices.Add(Key, PartitionIndex);
+
+	FTargetSystemPartition& Partition = Partitions[PartitionIndex];
+	Partition.Level = Level;
+	return Partition;
+}
+
+void UTargetSystemSubsystem::RemovePartition(ULevel* Level)
+{
+	int32 PartitionIndex = INDEX_NONE;
+	if (PartitionIndices.RemoveAndCopyValue(TObjectKey<ULevel>(Level), PartitionIndex))
+	{
+		Partitions.RemoveAt(PartitionIndex);
+		++Revision;
+	}
+}
+
+void UTargetSystemSubsystem::RefreshPartitionBounds(FTargetSystemPartition& Partition, const double Time)
+{
+	float MaxSpeedSquared = 0.0f;
+	Partition.Bounds = FBox(ForceInit);
+	for (const FTargetSystemTarget& Target : Partition.Targets)
+	{
+		if (const AActor* Actor = Target.Actor.Get())
+		{
+			Partition.Bounds += Actor->GetActorLocation();
+			MaxSpeedSquared = FMath::Max(MaxSpeedSquared, static_cast<float>(Actor->GetVelocity().SizeSquared()));
+		}
+	}
+
+	Partition.BoundsTime = Time;
+	Partition.MaxTargetSpeed = FMath::Sqrt(MaxSpeedSquared);
+}
+
+void UTargetSystemSubsystem::UpdateRegistry()
+{
+	if (RegistryUpdateFrameNumber == GFrameCounter)
+	{
+		return;
+	}
+
+	RegistryUpdateFrameNumber = GFrameCounter;
+
+	// Register actors of streamed in levels, a budget per frame
+	int32 Budget = TargetSystemSubsystem::LevelRegistrationBudget;
+	while (Budget > 0 && PendingLevels.Num() > 0)
+	{
+		const ULevel* Level = PendingLevels[0].Level.Get();
+		if (!Level)
+		{
+			PendingLevels.RemoveAt(0);
+			PendingLevelActorIndex = 0;
+			continue;
+		}
+
+		const int32 EndIndex = FMath::Min(PendingLevelActorIndex + Budget, Level->Actors.Num());
+		RegisterLevelActors(*Level, PendingLevelActorIndex, EndIndex);
+
+		Budget -= EndIndex - PendingLevelActorIndex;
+		PendingLevelActorIndex = EndIndex;
+		if (PendingLevelActorIndex >= Level->Actors.Num())
+		{
+			PendingLevels.RemoveAt(0);
+			PendingLevelActorIndex = 0;
+		}
+	}
+
+	// Partitions not reached by any query don't get their snapshot taken, refresh the bounds of one of them per frame
+	// for targets moving into range to be found
+	if (Partitions.GetMaxIndex() > 0)
+	{
+		for (int32 Attempt = 0; Attempt < Partitions.GetMaxIndex(); ++Attempt)
+		{
+			const int32 PartitionIndex = NextBoundsRefreshPartition++ % Partitions.GetMaxIndex();
+			if (Partitions.IsAllocated(PartitionIndex))
+			{
+				RefreshPartitionBounds(Partitions[PartitionIndex], GetWorld()->GetTimeSeconds());
+				break;
+			}
+		}
+
+		NextBoundsRefreshPartition %= Partitions.GetMaxIndex();
+	}
+}
+
+void UTargetSystemSubsystem::RegisterPendingLevels(const FVector& Origin, const float Radius)
+{
+	// Last first, for the partly registered level to be handled once the others were removed
+	for (int32 PendingIndex = PendingLevels.Num() - 1; PendingIndex >= 0; --PendingIndex)
+	{
+		const FPendingLevel& PendingLevel = PendingLevels[PendingIndex];
+		const ULevel* Level = PendingLevel.Level.Get();
+		if (Level && PendingLevel.Bounds.IsValid && PendingLevel.Bounds.ComputeSquaredDistanceToPoint(Origin) > FMath::Square(Radius))
+		{
+			continue;
+		}
+
+		if (Level)
+		{
+			RegisterLevelActors(*Level, PendingIndex == 0 ? PendingLevelActorIndex : 0, Level->Actors.Num());
+		}
+
+		PendingLevels.RemoveAt(PendingIndex);
+		if (PendingIndex == 0)
+		{
+			PendingLevelActorIndex = 0;
+		}
+	}
+}
+
+void UTargetSystemSubsystem::RegisterLevelActors(const ULevel& Level, const int32 StartIndex, const int32 EndIndex)
+{
+	for (int32 ActorIndex = StartIndex; ActorIndex < EndIndex; ++ActorIndex)
+	{
+		AActor* Actor = Level.Actors[ActorIndex];
+		if (Actor && IsRegisteredClass(Actor))
+		{
+			RegisterActor(Actor);
+		}
+	}
+}
+
+bool UTargetSystemSubsystem::IsTargetable(const FTargetSystemTarget& Target, const AActor* Actor)
+{
+	if (Target.bHasPublishedTargetability)
+	{
+		return Target.bPublishedTargetable;
+	}
+
+	switch (Target.Dispatch)
+	{
+	case ETargetSystemTargetableDispatch::Native:
+		return Target.NativeInterface->IsTargetableNative();
+	case ETargetSystemTargetableDispatch::Script:
+		return ITargetSystemTargetableInterface::Execute_IsTargetable(Actor);
+	default:
+		return true;
+	}
+}
+
+FTargetSystemTargetingData UTargetSystemSubsystem::GetTargetingData(FTargetSystemTarget& Target, const AActor* Actor) const
+{
+	FTargetSystemTargetingData TargetingData = FTargetSystemTargetingData::MakeDefault(Actor);
+
+	if (!Target.bAimSocketResolved)
+	{
+		ResolveAimSocket(Target, Actor);
+	}
+
+	GetSocketAimPoint(Target, TargetingData.AimPoint);
+
+	switch (Target.TargetingDataDispatch)
+	{
+	case ETargetSystemTargetableDispatch::Native:
+		Target.NativeInterface->GetTargetingDataNative(TargetingData);
+		break;
+	case ETargetSystemTargetableDispatch::Script:
+		TargetingData = ITargetSystemTargetableInterface::Execute_GetTargetingData(Actor, TargetingData);
+		break;
+	default:
+		break;
+	}
+
+	return TargetingData;
+}
+
+FName UTargetSystemSubsystem::GetAimSocket(const AActor* Actor) const
+{
+	for (int32 ClassIndex = 0; ClassIndex < TargetableClasses.Num(); ++ClassIndex)
+	{
+		if (TargetableClassAimSockets[ClassIndex] != NAME_None && Actor->IsA(TargetableClasses[ClassIndex]))
+		{
+			return TargetableClassAimSockets[ClassIndex];
+		}
+	}
+
+	return NAME_None;
+}
+
+void UTargetSystemSubsystem::ResolveAimSocket(FTargetSystemTarget& Target, const AActor* Actor) const
+{
+	Target.bAimSocketResolved = true;
+	Target.AimComponent = nullptr;
+	Target.AimSocket = FTargetSystemResolvedSocket();
+
+	const FName AimSocket = GetAimSocket(Actor);
+	if (AimSocket == NAME_None)
+	{
+		return;
+	}
+
+	// Same mesh the LockedOn Widget attaches to
+	const UMeshComponent* MeshComponent = Actor->FindComponentByClass<UMeshComponent>();
+	if (!TargetSystemSubsystem::ResolveSocket(MeshComponent, AimSocket, Target.AimSocket))
+	{
+		TS_LOG(Verbose, TEXT("UTargetSystemSubsystem::ResolveAimSocket - %s has no %s socket, using its location"), *GetNameSafe(Actor), *AimSocket.ToString());
+		return;
+	}
+
+	Target.AimComponent = MeshComponent;
+}
+
+bool UTargetSystemSubsystem::GetSocketAimPoint(const FTargetSystemTarget& Target, FVector& OutAimPoint)
+{
+	return TargetSystemSubsystem::GetSocketLocation(Target.AimComponent.Get(), Target.AimSocket, OutAimPoint);
+}
+
+FTargetSystemTargetVisibilityPoints& UTargetSystemSubsystem::FindOrAddVisibilityPoints(FTargetSystemTarget& Target, const int32 Set)
+{
+	for (FTargetSystemTargetVisibilityPoints& Points : Target.VisibilityPoints)
+	{
+		if (Points.Set == Set)
+		{
+			return Points;
+		}
+	}
+
+	FTargetSystemTargetVisibilityPoints& Points = Target.VisibilityPoints.AddDefaulted_GetRef();
+	Points.Set = Set;
+	return Points;
+}
+
+void UTargetSystemSubsystem::ResolveVisibilitySockets(FTargetSystemTargetVisibilityPoints& Points, const AActor* Actor) const
+{
+	const TArray<FName>& Sockets = VisibilityPointSets[Points.Set].Sockets;
+
+	// Same mesh as the aim socket
+	const UMeshComponent* MeshComponent = Actor->FindComponentByClass<UMeshComponent>();
+	Points.bSocketsResolved = true;
+	Points.SocketComponent = MeshComponent;
+	Points.Sockets.SetNum(Sockets.Num());
+	for (int32 SocketIndex = 0; SocketIndex < Sockets.Num(); ++SocketIndex)
+	{
+		TargetSystemSubsystem::ResolveSocket(MeshComponent, Sockets[SocketIndex], Points.Sockets[SocketIndex]);
+	}
+}
+
+void UTargetSystemSubsystem::InvalidateAimSockets()
+{
+	for (FTargetSystemPartition& Partition : Partitions)
+	{
+		for (FTargetSystemTarget& Target : Partition.Targets)
+		{
+			Target.bAimSocketResolved = false;
+			for (FTargetSystemTargetVisibilityPoints& Points : Target.VisibilityPoints)
+			{
+				Points.bSocketsResolved = false;
+			}
+		}
+
+		Partition.bSnapshotDirty = true;
+	}
+
+	++Revision;
+}
+
+void UTargetSystemSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (IsRegisteredClass(Actor))
+	{
+		RegisterActor(Actor);
+	}
+}
+
+void UTargetSystemSubsystem::OnActorDestroyed(AActor* Actor)
+{
+	UnregisterActor(Actor);
+}
+
+void UTargetSystemSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || !Level)
+	{
+		return;
+	}
+
+	// Actors get registered over the next frames, see UpdateRegistry(), or as soon as a query reaches the level bounds
+	if (!PendingLevels.ContainsByPredicate([Level](const FPendingLevel& PendingLevel) { return PendingLevel.Level == Level; }))
+	{
+		const ALevelBounds* LevelBounds = Level->LevelBoundsActor.Get();
+		PendingLevels.Add({ Level, LevelBounds ? LevelBounds->GetComponentsBoundingBox() : FBox(ForceInit) });
+	}
+}
+
+void UTargetSystemSubsystem::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	// A null level means every level is being removed
+	if (!Level)
+	{
+		Partitions.Reset();
+		PartitionIndices.Reset();
+		PendingLevels.Reset();
+		PendingLevelActorIndex = 0;
+		++Revision;
+		return;
+	}
+
+	const int32 PendingIndex = PendingLevels.IndexOfByPredicate([Level](const FPendingLevel& PendingLevel) { return PendingLevel.Level == Level; });
+	if (PendingIndex != INDEX_NONE)
+	{
+		PendingLevels.RemoveAt(PendingIndex);
+		if (PendingIndex == 0)
+		{
+			PendingLevelActorIndex = 0;
+		}
+	}
+
+	RemovePartition(Level);
+}
+
+void UTargetSystemSubsystem::OnTargetabilityChanged(AActor* Actor, const bool bIsTargetable)
+{
+	FTargetSystemPartition* Partition = FindPartition(Actor);
+	const int32* Index = Partition ? Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)) : nullptr;
+	if (!Index)
+	{
+		return;
+	}
+
+	FTargetSystemTarget& Target = Partition->Targets[*Index];
+	Target.bHasPublishedTargetability = true;
+	Target.bPublishedTargetable = bIsTargetable;
+	++Revision;
+
+	// Patch this frame snapshot in place rather than taking it again
+	if (!Partition->bSnapshotDirty && Partition->Snapshot.Targetable.IsValidIndex(*Index))
+	{
+		Partition->Snapshot.Targetable[*Index] = bIsTargetable;
+	}
+}
+
+void UTargetSystemSubsystem::OnGameplayTagsChanged(AActor* Actor)
+{
+	FTargetSystemPartition* Partition = FindPartition(Actor);
+	const int32* Index = Partition ? Partition->TargetIndices.Find(TObjectKey<AActor>(Actor)) : nullptr;
+	if (!Index)
+	{
+		return;
+	}
+
+	FTargetSystemTarget& Target = Partition->Targets[*Index];
+	MirrorTargetTags(Target);
+	++Revision;
+
+	// Patch this frame snapshot in place rather than taking it again
+	if (!Partition->bSnapshotDirty && Partition->Snapshot.TagBits.IsValidIndex(*Index))
+	{
+		Partition->Snapshot.TagBits[*Index] = Target.TagBits;
+	}
+}
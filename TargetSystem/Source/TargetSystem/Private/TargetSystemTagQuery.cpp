@@ -0,0 +1,63 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemTagQuery.h"
+#include "GameplayTagAssetInterface.h"
+#include "GameFramework/Actor.h"
+
+bool FTargetSystemCompiledTagQuery::MatchesOwnedTags(const AActor* Actor) const
+{
+	check(IsInGameThread());
+
+	FGameplayTagContainer OwnedTags;
+	if (const IGameplayTagAssetInterface* TagAssetInterface = Cast<const IGameplayTagAssetInterface>(Actor))
+	{
+		TagAssetInterface->GetOwnedGameplayTags(OwnedTags);
+	}
+
+	return !UncompiledQuery.IsSet() || UncompiledQuery->Matches(OwnedTags);
+}
+
+bool FTargetSystemCompiledTagQuery::Matches(const int32 NodeIndex, const FTargetSystemTagBits& TagBits) const
+{
+	const FNode& Node = Nodes[NodeIndex];
+	switch (Node.Type)
+	{
+	case EGameplayTagQueryExprType::AnyTagsMatch:
+		return TagBits.HasAny(Node.Mask);
+	case EGameplayTagQueryExprType::AllTagsMatch:
+		return TagBits.HasAll(Node.Mask);
+	case EGameplayTagQueryExprType::NoTagsMatch:
+		return !TagBits.HasAny(Node.Mask);
+	case EGameplayTagQueryExprType::AnyExprMatch:
+		for (int32 Child = Node.FirstChild; Child < Node.FirstChild + Node.NumChildren; ++Child)
+		{
+			if (Matches(Child, TagBits))
+			{
+				return true;
+			}
+		}
+		return false;
+	case EGameplayTagQueryExprType::AllExprMatch:
+		for (int32 Child = Node.FirstChild; Child < Node.FirstChild + Node.NumChildren; ++Child)
+		{
+			if (!Matches(Child, TagBits))
+			{
+				return false;
+			}
+		}
+		return true;
+	case EGameplayTagQueryExprType::NoExprMatch:
+		for (int32 Child = Node.FirstChild; Child < Node.FirstChild + Node.NumChildren; ++Child)
+		{
+			if (Matches(Child, TagBits))
+			{
+				return false;
+			}
+		}
+		return true;
+	default:
+		// Queries with expressions we can not compile are matched by MatchesOwnedTags() instead
+		checkNoEntry();
+		return true;
+	}
+}
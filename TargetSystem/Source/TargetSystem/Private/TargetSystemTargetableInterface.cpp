@@ -3,3 +3,45 @@
 #include "TargetSystemTargetableInterface.h"
 
 // Add default functionality here for any ITargetSystemTargetableInterface functions that are not pure virtual.
+
+bool ITargetSystemTargetableInterface::IsTargetable_Implementation() const
+{
+	return true;
+}
+
+bool ITargetSystemTargetableInterface::IsTargetableNative() const
+{
+	return IsTargetable_Implementation();
+}
+
+FTargetSystemTargetingData ITargetSystemTargetableInterface::GetTargetingData_Implementation(const FTargetSystemTargetingData& DefaultTargetingData) const
+{
+	return DefaultTargetingData;
+}
+
+void ITargetSystemTargetableInterface::GetTargetingDataNative(FTargetSystemTargetingData& InOutTargetingData) const
+{
+	InOutTargetingData = GetTargetingData_Implementation(InOutTargetingData);
+}
+
+void ITargetSystemTargetableInterface::NotifyTargetabilityChanged(AActor* Target, const bool bIsTargetable)
+{
+	OnTargetabilityChanged().Broadcast(Target, bIsTargetable);
+}
+
+FTargetSystemTargetabilityChanged& ITargetSystemTargetableInterface::OnTargetabilityChanged()
+{
+	static FTargetSystemTargetabilityChanged TargetabilityChanged;
+	return TargetabilityChanged;
+}
+
+void ITargetSystemTargetableInterface::NotifyGameplayTagsChanged(AActor* Target)
+{
+	OnGameplayTagsChanged().Broadcast(Target);
+}
+
+FTargetSystemGameplayTagsChanged& ITargetSystemTargetableInterface::OnGameplayTagsChanged()
+{
+	static FTargetSystemGameplayTagsChanged GameplayTagsChanged;
+	return GameplayTagsChanged;
+}
@@ -0,0 +1,18 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemTypes.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/Actor.h"
+
+FTargetSystemTargetingData FTargetSystemTargetingData::MakeDefault(const AActor* Actor)
+{
+	FTargetSystemTargetingData TargetingData;
+	TargetingData.AimPoint = Actor->GetActorLocation();
+
+	if (const USceneComponent* RootComponent = Actor->GetRootComponent())
+	{
+		TargetingData.BoundingRadius = RootComponent->Bounds.SphereRadius;
+	}
+
+	return TargetingData;
+}
@@ -0,0 +1,73 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemViewProjection.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "SceneView.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
+
+void FTargetSystemViewProjection::Capture(const APlayerController* PlayerController)
+{
+	bIsValid = false;
+
+	const ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	if (!LocalPlayer || !LocalPlayer->ViewportClient)
+	{
+		return;
+	}
+
+	// Same projection APlayerController::ProjectWorldLocationToScreen goes through
+	FSceneViewProjectionData ProjectionData;
+	if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+	{
+		return;
+	}
+
+	ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+	ViewRect = ProjectionData.GetConstrainedViewRect();
+	LocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+	bIsValid = true;
+}
+
+bool FTargetSystemViewProjection::IsInViewport(const FVector& WorldLocation) const
+{
+	if (!bIsValid)
+	{
+		return true;
+	}
+
+	FVector2D ScreenLocation;
+	if (!FSceneView::ProjectWorldToScreen(WorldLocation, ViewRect, ViewProjectionMatrix, ScreenLocation))
+	{
+		return false;
+	}
+
+	return ScreenLocation.X > 0 && ScreenLocation.Y > 0 && ScreenLocation.X < ViewportSize.X && ScreenLocation.Y < ViewportSize.Y;
+}
+
+void FTargetSystemViewProjection::ProjectCandidates(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& Candidates, TArray<FVector2f>& OutScreenLocations) const
+{
+	check(bIsValid);
+
+	const FVector2D RectMin(ViewRect.Min);
+	const FVector2D RectSize(ViewRect.Width(), ViewRect.Height());
+
+	OutScreenLocations.SetNumUninitialized(Candidates.Num());
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		// Same math as FSceneView::ProjectWorldToScreen, without going through the player controller for each point
+		const FVector4 ClipLocation = ViewProjectionMatrix.TransformFVector4(FVector4(Snapshot.AimPoints[Candidates[Index]], 1.0));
+		if (ClipLocation.W <= 0.0)
+		{
+			OutScreenLocations[Index] = FVector2f(-1.0f, -1.0f);
+			continue;
+		}
+
+		const double RHW = 1.0 / ClipLocation.W;
+		OutScreenLocations[Index] = FVector2f(
+			RectMin.X + (0.5 + ClipLocation.X * RHW * 0.5) * RectSize.X,
+			RectMin.Y + (0.5 - ClipLocation.Y * RHW * 0.5) * RectSize.Y
+		);
+	}
+}
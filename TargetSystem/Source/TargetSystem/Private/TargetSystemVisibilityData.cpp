@@ -0,0 +1,65 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemVisibilityData.h"
+
+bool UTargetSystemVisibilityData::IsStaticallyClear(const FVector& Start, const FVector& End) const
+{
+	FIntVector StartCell;
+	FIntVector EndCell;
+	if (!GetCell(Start, StartCell) || !GetCell(End, EndCell))
+	{
+		return false;
+	}
+
+	const int32 PairIndex = GetPairIndex(StartCell, EndCell);
+	const int32 WordIndex = PairIndex / PairsPerWord;
+	return PairIndex != INDEX_NONE && ClearPairBits.IsValidIndex(WordIndex)
+		&& (ClearPairBits[WordIndex] >> (PairIndex % PairsPerWord) & 1u) != 0;
+}
+
+bool UTargetSystemVisibilityData::GetCell(const FVector& Location, FIntVector& OutCell) const
+{
+	if (CellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	const FVector CellLocation = (Location - Origin) / CellSize;
+	OutCell = FIntVector(FMath::FloorToInt(CellLocation.X), FMath::FloorToInt(CellLocation.Y), FMath::FloorToInt(CellLocation.Z));
+	return OutCell.X >= 0 && OutCell.Y >= 0 && OutCell.Z >= 0 && OutCell.X < Dimensions.X && OutCell.Y < Dimensions.Y && OutCell.Z < Dimensions.Z;
+}
+
+int32 UTargetSystemVisibilityData::GetNumOffsets() const
+{
+	return (2 * CellRadius.X + 1) * (2 * CellRadius.Y + 1) * (2 * CellRadius.Z + 1);
+}
+
+int32 UTargetSystemVisibilityData::GetPairIndex(const FIntVector& From, const FIntVector& To) const
+{
+	const FIntVector Offset = To - From;
+	if (FMath::Abs(Offset.X) > CellRadius.X || FMath::Abs(Offset.Y) > CellRadius.Y || FMath::Abs(Offset.Z) > CellRadius.Z)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 NumOffsets = GetNumOffsets();
+	const int32 ZeroOffsetIndex = NumOffsets / 2;
+	int32 OffsetIndex = (Offset.X + CellRadius.X) + (2 * CellRadius.X + 1) * ((Offset.Y + CellRadius.Y) + (2 * CellRadius.Y + 1) * (Offset.Z + CellRadius.Z));
+
+	// Both cells of a pair are the same cell
+	if (OffsetIndex == ZeroOffsetIndex)
+	{
+		return INDEX_NONE;
+	}
+
+	// Offsets before the zero one are stored from the other cell, the negated offset mirroring the linear index
+	FIntVector Cell = From;
+	if (OffsetIndex < ZeroOffsetIndex)
+	{
+		Cell = To;
+		OffsetIndex = NumOffsets - 1 - OffsetIndex;
+	}
+
+	const int32 CellIndex = Cell.X + Dimensions.X * (Cell.Y + Dimensions.Y * Cell.Z);
+	return CellIndex * ZeroOffsetIndex + (OffsetIndex - ZeroOffsetIndex - 1);
+}
@@ -0,0 +1,33 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemVisibilityVolume.h"
+#include "TargetSystemSubsystem.h"
+#include "Engine/World.h"
+
+ATargetSystemVisibilityVolume::ATargetSystemVisibilityVolume()
+{
+	VisibilityData = nullptr;
+	CellSize = 200.0f;
+	MaxDistance = 1200.0f;
+	TraceChannel = ECC_Pawn;
+}
+
+void ATargetSystemVisibilityVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UTargetSystemSubsystem* Subsystem = UWorld::GetSubsystem<UTargetSystemSubsystem>(GetWorld()))
+	{
+		Subsystem->AddStaticVisibility(VisibilityData);
+	}
+}
+
+void ATargetSystemVisibilityVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UTargetSystemSubsystem* Subsystem = UWorld::GetSubsystem<UTargetSystemSubsystem>(GetWorld()))
+	{
+		Subsystem->RemoveStaticVisibility(VisibilityData);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
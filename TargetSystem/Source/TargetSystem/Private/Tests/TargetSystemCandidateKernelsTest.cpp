@@ -0,0 +1,162 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemParallelThresholdScope.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSystemCandidateKernelsTest
+{
+	static const int32 CandidateCounts[] = { 1024, 4096, 16384 };
+
+	// Spread over a few square kilometers, with one in four candidates on an ignored team, one in five not rendered
+	// recently, one in seven untargetable and a few priority levels
+	static void MakeSnapshot(const int32 NumCandidates, FTargetSystemCandidateSnapshot& OutSnapshot)
+	{
+		FRandomStream RandomStream(NumCandidates);
+		OutSnapshot.Reset(NumCandidates);
+		for (int32 Index = 0; Index < NumCandidates; ++Index)
+		{
+			FTargetSystemTargetingData TargetingData;
+			TargetingData.AimPoint = FVector(RandomStream.FRandRange(-1.0e5, 1.0e5), RandomStream.FRandRange(-1.0e5, 1.0e5), RandomStream.FRandRange(0.0, 1.0e3));
+			TargetingData.Priority = static_cast<float>(Index % 3);
+			TargetingData.TeamBits = Index % 4 == 0 ? 0x2 : 0x1;
+			OutSnapshot.Add(nullptr, TargetingData, Index % 7 != 0, FTargetSystemTagBits(), Index % 5 == 0 ? 0.0f : 10.0f);
+		}
+		OutSnapshot.Rebase(FVector::ZeroVector);
+	}
+
+	static FTargetSystemCandidateFilter MakeFilter()
+	{
+		FTargetSystemCandidateFilter CandidateFilter;
+		CandidateFilter.IgnoredRelationBits = FTargetSystemTargetingData::MakeRelationBits(0x2, 0);
+		CandidateFilter.MinLastRenderTime = 5.0f;
+		return CandidateFilter;
+	}
+
+	// Results of one component query over the snapshot
+	struct FQueryResult
+	{
+		TArray<int32> Candidates;
+		TArray<float> DistancesSquared;
+		int32 Best = INDEX_NONE;
+	};
+
+	static const FVector QueryLocation(1234.0, -5678.0, 90.0);
+
+	static void RunQuery(const FTargetSystemCandidateSnapshot& Snapshot, FQueryResult& OutResult)
+	{
+		OutResult.Candidates.Reset();
+		Snapshot.Filter(MakeFilter(), OutResult.Candidates);
+		Snapshot.GetDistancesSquared(QueryLocation, OutResult.Candidates, OutResult.DistancesSquared);
+		OutResult.Best = Snapshot.FindBest(OutResult.Candidates, OutResult.DistancesSquared, FMath::Square(5.0e4f));
+	}
+
+	// Average time of Function over NumIterations calls, in microseconds, after a warm up call
+	template <typename FunctionType>
+	static double TimeMicroseconds(const int32 NumIterations, FunctionType&& Function)
+	{
+		Function();
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Function();
+		}
+
+		return (FPlatformTime::Seconds() - StartTime) * 1.0e6 / NumIterations;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemCandidateKernelsParallelTest, "TargetSystem.CandidateSnapshot.ParallelMatchesSerial",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemCandidateKernelsParallelTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemCandidateKernelsTest;
+
+	for (const int32 NumCandidates : CandidateCounts)
+	{
+		FTargetSystemCandidateSnapshot Snapshot;
+		MakeSnapshot(NumCandidates, Snapshot);
+
+		FQueryResult SerialResult;
+		{
+			FTargetSystemParallelThresholdScope ThresholdScope(0);
+			RunQuery(Snapshot, SerialResult);
+		}
+
+		FQueryResult ParallelResult;
+		{
+			FTargetSystemParallelThresholdScope ThresholdScope(1);
+			RunQuery(Snapshot, ParallelResult);
+		}
+
+		// Each chunk computes its own range the same way the serial loop does, results are expected to be identical
+		TestTrue(FString::Printf(TEXT("Filtered candidates with %d candidates"), NumCandidates), SerialResult.Candidates == ParallelResult.Candidates);
+		TestTrue(FString::Printf(TEXT("Squared distances with %d candidates"), NumCandidates), SerialResult.DistancesSquared == ParallelResult.DistancesSquared);
+		TestEqual(FString::Printf(TEXT("Best candidate with %d candidates"), NumCandidates), ParallelResult.Best, SerialResult.Best);
+		TestTrue(FString::Printf(TEXT("Best candidate found with %d candidates"), NumCandidates), SerialResult.Best != INDEX_NONE);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemCandidateKernelsBenchmark, "TargetSystem.CandidateSnapshot.KernelsBenchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FTargetSystemCandidateKernelsBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemCandidateKernelsTest;
+
+	constexpr int32 NumIterations = 200;
+
+	for (const int32 NumCandidates : CandidateCounts)
+	{
+		FTargetSystemCandidateSnapshot Snapshot;
+		MakeSnapshot(NumCandidates, Snapshot);
+
+		FQueryResult Result;
+		RunQuery(Snapshot, Result);
+
+		// Serial then parallel timings of each kernel, on the same inputs
+		double Timings[2][3];
+		for (int32 Path = 0; Path < 2; ++Path)
+		{
+			FTargetSystemParallelThresholdScope ThresholdScope(Path == 0 ? 0 : 1);
+			const FTargetSystemCandidateFilter CandidateFilter = MakeFilter();
+
+			TArray<int32> Candidates;
+			Candidates.Reserve(NumCandidates);
+			Timings[Path][0] = TimeMicroseconds(NumIterations, [&]()
+			{
+				Candidates.Reset();
+				Snapshot.Filter(CandidateFilter, Candidates);
+			});
+
+			TArray<float> DistancesSquared;
+			Timings[Path][1] = TimeMicroseconds(NumIterations, [&]()
+			{
+				Snapshot.GetDistancesSquared(QueryLocation, Result.Candidates, DistancesSquared);
+			});
+
+			Timings[Path][2] = TimeMicroseconds(NumIterations, [&]()
+			{
+				Snapshot.FindBest(Result.Candidates, Result.DistancesSquared, FMath::Square(5.0e4f));
+			});
+		}
+
+		static const TCHAR* KernelNames[] = { TEXT("Filter"), TEXT("GetDistancesSquared"), TEXT("FindBest") };
+		for (int32 Kernel = 0; Kernel < UE_ARRAY_COUNT(KernelNames); ++Kernel)
+		{
+			AddInfo(FString::Printf(TEXT("%s, %d candidates: serial %.2f us, parallel %.2f us, x%.2f"), KernelNames[Kernel], NumCandidates,
+				Timings[0][Kernel], Timings[1][Kernel], Timings[0][Kernel] / FMath::Max(Timings[1][Kernel], UE_DOUBLE_SMALL_NUMBER)));
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,112 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemParallelThresholdScope.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSystemCandidateSnapshotTest
+{
+	// Far enough for world space floats to be 0.0625 units apart
+	static const FVector FarOrigin(1.0e6, -1.0e6, 1.0e6);
+
+	static void AddCandidate(FTargetSystemCandidateSnapshot& Snapshot, const FVector& AimPoint)
+	{
+		FTargetSystemTargetingData TargetingData;
+		TargetingData.AimPoint = AimPoint;
+		Snapshot.Add(nullptr, TargetingData, true, FTargetSystemTagBits(), 0.0f);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemCandidateSnapshotPrecisionTest, "TargetSystem.CandidateSnapshot.RelativePrecision",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemCandidateSnapshotPrecisionTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemCandidateSnapshotTest;
+
+	// Two candidates a hundredth of a unit apart, the same point once stored as world space floats
+	FTargetSystemCandidateSnapshot Snapshot;
+	AddCandidate(Snapshot, FarOrigin + FVector(10.02, 0.0, 0.0));
+	AddCandidate(Snapshot, FarOrigin + FVector(10.01, 0.0, 0.0));
+	AddCandidate(Snapshot, FarOrigin + FVector(0.0, 100.0, 0.0));
+	Snapshot.Rebase(FarOrigin);
+
+	const TArray<int32> Candidates = { 0, 1, 2 };
+	const FVector Location = FarOrigin + FVector(0.5, 0.0, 0.0);
+
+	TArray<float> DistancesSquared;
+	Snapshot.GetDistancesSquared(Location, Candidates, DistancesSquared);
+	for (const int32 Candidate : Candidates)
+	{
+		const double Expected = FVector::DistSquared(Snapshot.AimPoints[Candidate], Location);
+		TestEqual(FString::Printf(TEXT("Squared distance of candidate %d"), Candidate), static_cast<double>(DistancesSquared[Candidate]), Expected, 1.0e-2);
+	}
+
+	TestEqual(TEXT("Closest candidate"), Snapshot.FindBest(Candidates, DistancesSquared, TNumericLimits<float>::Max()), 1);
+
+	// Candidate 2 is along +Y, 90 degrees to the left of a view looking along +X
+	TArray<float> Angles;
+	Snapshot.GetYawAngles(FarOrigin, 0.0f, Candidates, Angles);
+	TestEqual(TEXT("Yaw angle of candidate 2"), Angles[2], 270.0f, 1.0e-2f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemCandidateSnapshotTieBreakTest, "TargetSystem.CandidateSnapshot.ParallelTieBreak",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemCandidateSnapshotTieBreakTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemCandidateSnapshotTest;
+
+	// Several chunks worth of candidates, with ties on priority and value spread over different chunks
+	constexpr int32 NumCandidates = 4096;
+	FTargetSystemCandidateSnapshot Snapshot;
+	TArray<int32> Candidates;
+	TArray<float> Values;
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		FTargetSystemTargetingData TargetingData;
+		TargetingData.Priority = Index % 1024 == 300 ? 1.0f : 0.0f;
+		Snapshot.Add(nullptr, TargetingData, true, FTargetSystemTagBits(), 0.0f);
+		Candidates.Add(Index);
+		Values.Add(Index % 3 == 0 ? 10.0f : 20.0f);
+	}
+
+	// Candidates 300, 1324, 2348 and 3372 share the highest priority, 300 and 3372 the smallest value among them
+	constexpr int32 ExpectedBest = 300;
+
+	for (int32 Run = 0; Run < 8; ++Run)
+	{
+		int32 SerialBest;
+		{
+			FTargetSystemParallelThresholdScope ThresholdScope(0);
+			SerialBest = Snapshot.FindBest(Candidates, Values, TNumericLimits<float>::Max());
+		}
+
+		int32 ParallelBest;
+		{
+			FTargetSystemParallelThresholdScope ThresholdScope(1);
+			ParallelBest = Snapshot.FindBest(Candidates, Values, TNumericLimits<float>::Max());
+		}
+
+		TestEqual(TEXT("Serial best candidate"), SerialBest, ExpectedBest);
+		TestEqual(TEXT("Parallel best candidate"), ParallelBest, ExpectedBest);
+	}
+
+	// Without priorities, the first smallest value wins
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		Snapshot.Priorities[Index] = 0.0f;
+	}
+
+	FTargetSystemParallelThresholdScope ThresholdScope(1);
+	TestEqual(TEXT("Parallel best candidate without priorities"), Snapshot.FindBest(Candidates, Values, TNumericLimits<float>::Max()), 0);
+	TestEqual(TEXT("Parallel best candidate below the max value"), Snapshot.FindBest(Candidates, Values, 10.0f), static_cast<int32>(INDEX_NONE));
+
+	return true;
+}
+
+#endif
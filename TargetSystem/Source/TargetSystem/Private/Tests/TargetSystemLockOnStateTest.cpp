@@ -0,0 +1,48 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "TargetSystemLockOnState.h"
+#include "GameFramework/Actor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemLockOnStateAxisInputTest, "TargetSystem.LockOnState.OutOfRangeWithAxisInput",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemLockOnStateAxisInputTest::RunTest(const FString& Parameters)
+{
+	FTargetSystemLockOnParams Params;
+	Params.MinimumDistanceToEnable = 1000.0f;
+	Params.LockOffGraceTime = 1.0f;
+
+	AActor* Target = NewObject<AActor>(GetTransientPackage());
+	FTargetSystemLockOnState State;
+	State.LockOn(Target);
+
+	// Target out of range on every tick, with axis input fed in between as games do every frame
+	FTargetSystemLockOnInput TickInput;
+	TickInput.DistanceToTarget = 2000.0f;
+	TickInput.bHasTargetState = true;
+
+	FTargetSystemLockOnInput AxisInput;
+	AxisInput.SwitchAxisValue = 0.1f;
+	AxisInput.bHasSwitchAxisInput = true;
+
+	constexpr float DeltaTime = 0.1f;
+	int32 LockOffStep = INDEX_NONE;
+	for (int32 Step = 0; Step < 20 && LockOffStep == INDEX_NONE; ++Step)
+	{
+		if (State.Step(Params, TickInput, DeltaTime).bShouldLockOff)
+		{
+			LockOffStep = Step;
+		}
+
+		TestFalse(TEXT("Axis input alone locks off"), State.Step(Params, AxisInput, 0.0f).bShouldLockOff);
+	}
+
+	// Out of range from the first tick, at 0.1s, locked off once the grace time passed, at 1.1s
+	TestEqual(TEXT("Step locking off"), LockOffStep, 10);
+	return true;
+}
+
+#endif
@@ -0,0 +1,29 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+
+// Sets TargetSystem.ParallelCandidateThreshold for the lifetime of the scope, 0 to force the serial kernels, 1 to
+// force the parallel ones.
+class FTargetSystemParallelThresholdScope
+{
+public:
+	explicit FTargetSystemParallelThresholdScope(const int32 Threshold)
+		: Variable(IConsoleManager::Get().FindConsoleVariable(TEXT("TargetSystem.ParallelCandidateThreshold")))
+	{
+		check(Variable);
+		PreviousThreshold = Variable->GetInt();
+		Variable->Set(Threshold, ECVF_SetByCode);
+	}
+
+	~FTargetSystemParallelThresholdScope()
+	{
+		Variable->Set(PreviousThreshold, ECVF_SetByCode);
+	}
+
+private:
+	IConsoleVariable* Variable = nullptr;
+	int32 PreviousThreshold = 0;
+};
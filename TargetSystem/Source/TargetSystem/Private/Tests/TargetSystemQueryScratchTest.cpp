@@ -0,0 +1,64 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemQueryScratch.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSystemQueryScratchTest
+{
+	// Above the default TargetSystem.ParallelCandidateThreshold, for the parallel kernels to run as well
+	static constexpr int32 NumCandidates = 2000;
+
+	// Same buffers and kernels as the component queries
+	static void RunQuery(const FTargetSystemCandidateSnapshot& Snapshot, FTargetSystemQueryScratch& Scratch)
+	{
+		FTargetSystemQueryScratchScope ScratchScope(Scratch);
+
+		Snapshot.Filter(FTargetSystemCandidateFilter(), Scratch.Candidates);
+		Snapshot.GetDistancesSquared(FVector::ZeroVector, Scratch.Candidates, Scratch.DistancesSquared);
+		Snapshot.GetYawAngles(FVector::ZeroVector, 0.0f, Scratch.Candidates, Scratch.Angles);
+		Snapshot.FindBest(Scratch.Candidates, Scratch.DistancesSquared, TNumericLimits<float>::Max());
+
+		for (const int32 Candidate : Scratch.Candidates)
+		{
+			if (Candidate % 2 == 0)
+			{
+				Scratch.VisibleCandidates.Add(Candidate);
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemQueryScratchGrowthTest, "TargetSystem.QueryScratch.NoGrowthAfterWarmUp",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemQueryScratchGrowthTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemQueryScratchTest;
+
+	FTargetSystemCandidateSnapshot Snapshot;
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		FTargetSystemTargetingData TargetingData;
+		TargetingData.AimPoint = FVector(Index * 10.0, (Index % 7) * 100.0, 0.0);
+		Snapshot.Add(nullptr, TargetingData, true, FTargetSystemTagBits(), 0.0f);
+	}
+	Snapshot.Rebase(FVector::ZeroVector);
+
+	FTargetSystemQueryScratch Scratch;
+	RunQuery(Snapshot, Scratch);
+	TestTrue(TEXT("Warm up query grew the buffers"), Scratch.NumGrowths > 0);
+
+	Scratch.NumGrowths = 0;
+	for (int32 Query = 0; Query < 16; ++Query)
+	{
+		RunQuery(Snapshot, Scratch);
+	}
+
+	TestEqual(TEXT("Growths after warm up"), Scratch.NumGrowths, 0u);
+	return true;
+}
+
+#endif
@@ -0,0 +1,42 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "TargetSystemTestTarget.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSystemTargetableInterfaceDefaultsTest, "TargetSystem.TargetableInterface.NativeDefaults",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemTargetableInterfaceDefaultsTest::RunTest(const FString& Parameters)
+{
+	ATargetSystemTestTarget* Target = NewObject<ATargetSystemTestTarget>(GetTransientPackage());
+	const ITargetSystemTargetableInterface* Interface = Target;
+
+	FTargetSystemTargetingData DefaultTargetingData;
+	DefaultTargetingData.AimPoint = FVector(100.0, -200.0, 300.0);
+	DefaultTargetingData.BoundingRadius = 50.0f;
+	DefaultTargetingData.Priority = 2.0f;
+
+	// Not overriding GetTargetingData keeps the defaults computed from the actor, through the native path and the event
+	FTargetSystemTargetingData TargetingData = DefaultTargetingData;
+	Interface->GetTargetingDataNative(TargetingData);
+	TestEqual(TEXT("Native path aim point"), TargetingData.AimPoint, DefaultTargetingData.AimPoint);
+	TestEqual(TEXT("Native path bounding radius"), TargetingData.BoundingRadius, DefaultTargetingData.BoundingRadius);
+	TestEqual(TEXT("Native path priority"), TargetingData.Priority, DefaultTargetingData.Priority);
+
+	TargetingData = ITargetSystemTargetableInterface::Execute_GetTargetingData(Target, DefaultTargetingData);
+	TestEqual(TEXT("Event aim point"), TargetingData.AimPoint, DefaultTargetingData.AimPoint);
+	TestEqual(TEXT("Event bounding radius"), TargetingData.BoundingRadius, DefaultTargetingData.BoundingRadius);
+
+	// While the IsTargetable override is used by both the event and the native path, which calls it directly
+	TestFalse(TEXT("Targetable through the event"), ITargetSystemTargetableInterface::Execute_IsTargetable(Target));
+	TestFalse(TEXT("Targetable through the native path"), Interface->IsTargetableNative());
+	Target->bTargetable = true;
+	TestTrue(TEXT("Targetable through the event"), ITargetSystemTargetableInterface::Execute_IsTargetable(Target));
+	TestTrue(TEXT("Targetable through the native path"), Interface->IsTargetableNative());
+
+	return true;
+}
+
+#endif
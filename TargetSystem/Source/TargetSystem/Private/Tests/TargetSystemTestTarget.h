@@ -0,0 +1,23 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TargetSystemTargetableInterface.h"
+#include "TargetSystemTestTarget.generated.h"
+
+// C++ target only implementing IsTargetable, as most native targets do.
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown, Transient)
+class ATargetSystemTestTarget : public AActor, public ITargetSystemTargetableInterface
+{
+	GENERATED_BODY()
+
+public:
+	bool bTargetable = false;
+
+	virtual bool IsTargetable_Implementation() const override
+	{
+		return bTargetable;
+	}
+};
@@ -0,0 +1,47 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "TargetSystemAcquireTargetAction.generated.h"
+
+class UTargetSystemComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTargetSystemAcquireTargetPin, AActor*, Target);
+
+// Blueprint async node for UTargetSystemComponent::TargetActorAsync().
+UCLASS()
+class TARGETSYSTEM_API UTargetSystemAcquireTargetAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	// Called with the nearest visible target.
+	UPROPERTY(BlueprintAssignable)
+	FTargetSystemAcquireTargetPin Acquired;
+
+	// Called when no target could be acquired.
+	UPROPERTY(BlueprintAssignable)
+	FTargetSystemAcquireTargetPin NotFound;
+
+	/**
+	 * Acquires the nearest visible target without blocking the game thread, the result comes in a frame or two later.
+	 *
+	 * @param TargetSystemComponent The component to acquire a target for
+	 * @param bLockOn Whether to lock on the acquired target, as TargetActor does
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Target System", meta = (BlueprintInternalUseOnly = "true"))
+	static UTargetSystemAcquireTargetAction* AcquireTargetAsync(UTargetSystemComponent* TargetSystemComponent, bool bLockOn = true);
+
+	//~ UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+
+private:
+	UPROPERTY()
+	UTargetSystemComponent* TargetSystemComponent;
+
+	bool bLockOn = true;
+
+	void OnAcquisitionComplete(AActor* Target);
+};
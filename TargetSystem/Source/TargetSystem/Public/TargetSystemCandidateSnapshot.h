@@ -0,0 +1,130 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TargetSystemTagQuery.h"
+#include "TargetSystemTypes.h"
+
+// Filters applied by FTargetSystemCandidateSnapshot::Filter, cheapest first. Untargetable candidates are always filtered out.
+struct TARGETSYSTEM_API FTargetSystemCandidateFilter
+{
+	// Candidates with any of these team / faction bits are filtered out (see FTargetSystemTargetingData::MakeRelationBits).
+	uint64 IgnoredRelationBits = 0;
+
+	// Optional tag query candidates must match. Queries that could not be compiled can only be used on the game thread.
+	const FTargetSystemCompiledTagQuery* TagQuery = nullptr;
+
+	// Class candidates must be a child of. No class filtering when null.
+	TSubclassOf<AActor> ActorClass;
+
+	// World time candidates must have been rendered since, see FTargetSystemCandidateSnapshot::LastRenderTimes. No
+	// filtering by default.
+	float MinLastRenderTime = TNumericLimits<float>::Lowest();
+};
+
+/**
+ * Targeting data of registered targets, taken once per frame by the Target System Subsystem for each of its partitions,
+ * and gathered by components from the partitions within range.
+ *
+ * Stored as a structure of arrays, all indexed by the same candidate index, so that component queries can filter and
+ * score candidates without calling back into the targets.
+ *
+ * Filtering and scoring kernels run with ParallelFor over chunks of candidates above TargetSystem.ParallelCandidateThreshold,
+ * each chunk writing its own range, so that results are the same as the serial path ones.
+ */
+struct TARGETSYSTEM_API FTargetSystemCandidateSnapshot
+{
+	// Frame (GFrameCounter) this snapshot was taken on.
+	uint64 FrameNumber = 0;
+
+	// Target System Subsystem revision this snapshot is up to date with.
+	uint32 Revision = 0;
+
+	TArray<AActor*> Actors;
+
+	// World space aim points, used for traces and reported back to the game.
+	TArray<FVector> AimPoints;
+	TArray<float> BoundingRadii;
+	TArray<float> Priorities;
+	// Team and faction bits, packed with FTargetSystemTargetingData::MakeRelationBits.
+	TArray<uint64> RelationBits;
+	TArray<FName> WidgetSockets;
+	TArray<bool> Targetable;
+	// World time the actor was last rendered, by any view, as of the previous frame (see AActor::GetLastRenderTime).
+	TArray<float> LastRenderTimes;
+
+	// Gameplay tags, mirrored from the registry.
+	TArray<FTargetSystemTagBits> TagBits;
+
+	// Origin of RelativeAimPoints, see Rebase().
+	FVector Origin = FVector::ZeroVector;
+
+	// AimPoints relative to Origin at float precision, for distance and angle kernels to run at float width. With
+	// Large World Coordinates, a float keeps sub millimeter precision within several kilometers of Origin.
+	TArray<FVector3f> RelativeAimPoints;
+
+	int32 Num() const
+	{
+		return Actors.Num();
+	}
+
+	void Reset(int32 NewSize = 0);
+
+	void Add(AActor* Actor, const FTargetSystemTargetingData& TargetingData, bool bIsTargetable, const FTargetSystemTagBits& InTagBits, float LastRenderTime);
+
+	// Appends every candidate of Other, without their relative aim points.
+	void Append(const FTargetSystemCandidateSnapshot& Other);
+
+	// Sets Origin and computes RelativeAimPoints from it. Gathered snapshots are rebased on the query origin cell center.
+	void Rebase(const FVector& NewOrigin);
+
+	FVector3f ToRelative(const FVector& WorldLocation) const
+	{
+		return FVector3f(WorldLocation - Origin);
+	}
+
+	// Fills OutDistancesSquared with the squared distance from Location to the aim point of each of Candidates.
+	template <typename CandidateAllocatorType, typename DistanceAllocatorType>
+	void GetDistancesSquared(const FVector& Location, const TArray<int32, CandidateAllocatorType>& Candidates, TArray<float, DistanceAllocatorType>& OutDistancesSquared) const
+	{
+		OutDistancesSquared.SetNumUninitialized(Candidates.Num());
+		GetDistancesSquared(Location, MakeArrayView(Candidates), MakeArrayView(OutDistancesSquared));
+	}
+
+	// OutDistancesSquared must be as large as Candidates.
+	void GetDistancesSquared(const FVector& Location, TArrayView<const int32> Candidates, TArrayView<float> OutDistancesSquared) const;
+
+	// Fills OutAngles with ViewYaw minus the yaw of the direction from ViewLocation to the aim point of each of
+	// Candidates, in degrees, wrapped to positive values.
+	void GetYawAngles(const FVector& ViewLocation, float ViewYaw, const TArray<int32>& Candidates, TArray<float>& OutAngles) const;
+
+	// Returns the index in Candidates of the highest priority candidate whose value is below MaxValue, the first smallest
+	// value among them, INDEX_NONE if none. Values are indexed as Candidates (distances, screen distances, ...).
+	int32 FindBest(const TArray<int32>& Candidates, const TArray<float>& Values, float MaxValue) const;
+
+	// Returns whether the candidate at index A ranks before the one at index B: higher priority, then smaller value.
+	bool IsBetter(int32 A, float ValueA, int32 B, float ValueB) const
+	{
+		return Priorities[A] > Priorities[B] || (Priorities[A] == Priorities[B] && ValueA < ValueB);
+	}
+
+	// Appends to OutCandidates the index of every candidate passing Filter.
+	template <typename AllocatorType>
+	void Filter(const FTargetSystemCandidateFilter& CandidateFilter, TArray<int32, AllocatorType>& OutCandidates) const
+	{
+		const int32 NumCandidates = OutCandidates.Num();
+		OutCandidates.AddUninitialized(Num());
+		const int32 NumPassed = Filter(CandidateFilter, MakeArrayView(OutCandidates).Slice(NumCandidates, Num()));
+		OutCandidates.SetNum(NumCandidates + NumPassed, EAllowShrinking::No);
+	}
+
+	// Writes the index of every candidate passing Filter at the start of OutCandidates, which must hold Num() entries,
+	// and returns their number.
+	int32 Filter(const FTargetSystemCandidateFilter& CandidateFilter, TArrayView<int32> OutCandidates) const;
+
+	// Returns whether the candidate at Index passes Filter, the single candidate case of Filter().
+	bool PassesFilter(const FTargetSystemCandidateFilter& CandidateFilter, int32 Index) const;
+
+	FTargetSystemTargetingData GetTargetingData(int32 Index) const;
+};
@@ -10,14 +10,29 @@
 #else
 #include "Engine/EngineTypes.h"
 #endif
+#include "CollisionQueryParams.h"
+#include "GameplayTagContainer.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemLockOnState.h"
+#include "TargetSystemQueryScratch.h"
+#include "TargetSystemTagQuery.h"
+#include "WorldCollision.h"
 #include "TargetSystemComponent.generated.h"
 
 class UUserWidget;
 class UWidgetComponent;
 class APlayerController;
+class UTargetSystemPreset;
+class UTargetSystemSubsystem;
+struct FStreamableHandle;
+struct FTargetSystemAcquisition;
+struct FTargetSystemCandidateFilter;
+struct FTargetSystemVisibilityPoint;
+struct FTargetSystemTargetingData;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FComponentOnTargetLockedOnOff, AActor*, TargetActor);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FComponentSetRotation, AActor*, TargetActor, FRotator, ControlRotation);
+DECLARE_DELEGATE_OneParam(FTargetSystemAcquisitionComplete, AActor* /* Target */);
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class TARGETSYSTEM_API UTargetSystemComponent : public UActorComponent
@@ -28,116 +43,43 @@ public:
 	// Sets default values for this component's properties
 	UTargetSystemComponent();
 
-	// The minimum distance to enable target locked on.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	float MinimumDistanceToEnable = 1200.0f;
-
-	// The AActor Subclass to search for targetable Actors.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	TSubclassOf<AActor> TargetableActors;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	TEnumAsByte<ECollisionChannel> TargetableCollisionChannel;
-
-	// Whether or not the character rotation should be controlled when Target is locked on.
-	//
-	// If true, it'll set the value of bUseControllerRotationYaw and bOrientationToMovement variables on Target locked on / off.
-	//
-	// Set it to true if you want the character to rotate around the locked on target to enable you to setup strafe animations.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	bool bShouldControlRotation = false;
-
-	// Whether to accept pitch input when bAdjustPitchBasedOnDistanceToTarget is disabled
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	bool bIgnoreLookInput = true;
-
-	// The amount of time to break line of sight when actor gets behind an Object.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	float BreakLineOfSightDelay = 2.0f;
-
-	// Lower this value is, easier it will be to switch new target on right or left. Must be < 1.0f if controlling with gamepad stick
-	//
-	// When using Sticky Feeling feature, it has no effect (see StickyRotationThreshold)
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
-	float StartRotatingThreshold = 0.85f;
-
-	// Whether or not the Target LockOn Widget indicator should be drawn and attached automatically.
-	//
-	// When set to false, this allow you to manually draw the widget for further control on where you'd like it to appear.
-	//
-	// OnTargetLockedOn and OnTargetLockedOff events can be used for this.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
-	bool bShouldDrawLockedOnWidget = true;
-
-	// The Widget Class to use when locked on Target. If not defined, will fallback to a Text-rendered
-	// widget with a single O character.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
-	TSubclassOf<UUserWidget> LockedOnWidgetClass;
-
-	// The Widget Draw Size for the Widget class to use when locked on Target.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
-	float LockedOnWidgetDrawSize = 32.0f;
-
-	// The Socket name to attach the LockedOn Widget.
+	// Tuning values shared by every component using this preset. When not set, the defaults of UTargetSystemPreset are used.
 	//
-	// You should use this to configure the Bone or Socket name the widget should be attached to, and allow
-	// the widget to move with target character's animation (Ex: spine_03)
-	//
-	// Set it to None to attach the Widget Component to the Root Component instead of the Mesh.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
-	FName LockedOnWidgetParentSocket = FName("spine_03");
-
-	// The Relative Location to apply on Target LockedOn Widget when attached to a target.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
-	FVector LockedOnWidgetRelativeLocation = FVector(0.0f, 0.0f, 0.0f);
+	// Presets are referenced by pointer, so that tuning values are neither duplicated nor serialized with each pawn.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System")
+	UTargetSystemPreset* Preset;
 
-	// Setting this to true will tell the Target System to adjust the Pitch Offset (the Y axis) when locked on,
-	// depending on the distance to the target actor.
-	//
-	// It will ensure that the Camera will be moved up vertically the closer this Actor gets to its target.
+	// Instance specific tuning values, used instead of Preset. Only allocated for the components that need one.
 	//
-	// Formula:
-	//
-	//   (DistanceToTarget * PitchDistanceCoefficient + PitchDistanceOffset) * -1.0f
-	//
-	// Then Clamped by PitchMin / PitchMax
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
-	bool bAdjustPitchBasedOnDistanceToTarget = true;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
-	float PitchDistanceCoefficient = -0.2f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
-	float PitchDistanceOffset = 60.0f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
-	float PitchMin = -50.0f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
-	float PitchMax = -20.0f;
-
-	// Set it to true / false whether you want a sticky feeling when switching target
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
-	bool bEnableStickyTarget = false;
-
-	// This value gets multiplied to the AxisValue to check against StickyRotationThreshold.
-	//
-	// Only used when Sticky Target is enabled.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
-	float AxisMultiplier = 1.0f;
-
-	// Lower this value is, easier it will be to switch new target on right or left.
-	//
-	// This is similar to StartRotatingThreshold, but you should set this to a much higher value.
-	//
-	// Only used when Sticky Target is enabled.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
-	float StickyRotationThreshold = 30.0f;
+	// This is a whole preset, not per value overrides: once set, later edits to Preset are ignored for every value, not
+	// only the ones changed here. Call ClearPresetOverride() to go back to Preset.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadOnly, Category = "Target System")
+	UTargetSystemPreset* PresetOverride;
 
 	// Function to call to target a new actor.
 	UFUNCTION(BlueprintCallable, Category = "Target System")
 	void TargetActor();
 
+	/**
+	 * Latent version of TargetActor(), acquiring the nearest visible target without blocking the game thread.
+	 *
+	 * Candidates are filtered, projected and sorted by distance in a task off the game thread, against a copy of this
+	 * frame candidate snapshot, then traced with asynchronous line traces: one per visibility point, as TargetActor()
+	 * does, unless the line of sight cache already knows the result. OnComplete is called on the game thread once
+	 * the result is known, usually a frame or two later, with nullptr if no target could be acquired. Starting another
+	 * acquisition completes the one in flight with nullptr.
+	 *
+	 * Unlike TargetActor(), this never locks off: when locked on, the acquired target replaces the current one.
+	 *
+	 * @param bLockOn Whether to lock on the acquired target
+	 * @param OnComplete Called with the acquired target
+	 * @return false if the acquisition could not be started, in which case OnComplete is not called
+	 */
+	bool TargetActorAsync(bool bLockOn, FTargetSystemAcquisitionComplete OnComplete = FTargetSystemAcquisitionComplete());
+
+	// Returns whether an acquisition started by TargetActorAsync() is in flight.
+	bool IsAcquiringTarget() const;
+
 	// Function to call to manually untarget.
 	UFUNCTION(BlueprintCallable, Category = "Target System")
 	void TargetLockOff();
@@ -154,7 +96,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Target System")
 	bool GetTargetLockedStatus();
 
-	// Called when a target is locked off, either if it is out of reach (based on MinimumDistanceToEnable) or behind an Object.
+	// Called when a target is locked off, either if it is out of reach (based on LockOffDistance) or behind an Object.
 	UPROPERTY(BlueprintAssignable, Category = "Target System")
 	FComponentOnTargetLockedOnOff OnTargetLockedOff;
 
@@ -169,6 +111,24 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Target System")
 	FComponentSetRotation OnTargetSetRotation;
 
+	// Called when the target TargetActor would lock on changes, with nullptr when there is none anymore.
+	//
+	// Only called when bMaintainBestCandidate is enabled, and while not locked on, to highlight a soft target.
+	UPROPERTY(BlueprintAssignable, Category = "Target System")
+	FComponentOnTargetLockedOnOff OnBestCandidateChanged;
+
+	// Returns the target TargetActor would lock on, as of the last best candidate scan (see bMaintainBestCandidate)
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	AActor* GetBestCandidate() const;
+
+	// Returns the candidate aim assist currently pulls towards, if any (see bEnableAimAssist).
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	AActor* GetAimAssistTarget() const;
+
+	// Returns the factor look input should be scaled by for aim assist slowdown, 1 when no candidate is assisted.
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	float GetAimAssistInputScale() const;
+
 	// Returns the reference to currently targeted Actor if any
 	UFUNCTION(BlueprintCallable, Category = "Target System")
 	AActor* GetLockedOnTargetActor() const;
@@ -177,7 +137,173 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Target System")
 	bool IsLocked() const;
 
+	/**
+	 * Notifies every Target System Component that Target changed its targetability.
+	 *
+	 * Actors implementing the Targetable Interface must call this whenever the value returned by IsTargetable() changes,
+	 * for components locked on them to lock off.
+	 *
+	 * @param Target The actor whose targetability changed
+	 * @param bIsTargetable The new value returned by IsTargetable()
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	static void NotifyTargetabilityChanged(AActor* Target, bool bIsTargetable);
+
+	/**
+	 * Notifies every Target System Component that the gameplay tags owned by Target changed.
+	 *
+	 * Target tags are mirrored by the Target System to be matched against TargetTagQuery, actors implementing
+	 * IGameplayTagAssetInterface must call this whenever their owned tags change.
+	 *
+	 * @param Target The actor whose owned gameplay tags changed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	static void NotifyGameplayTagsChanged(AActor* Target);
+
+	// Sets and compiles the gameplay tag query targets must match, replacing the preset one for this component, until
+	// ClearTargetTagQuery() is called. Kept when switching preset.
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetTargetTagQuery(const FGameplayTagQuery& InTargetTagQuery);
+
+	// Goes back to the gameplay tag query of the preset in use.
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void ClearTargetTagQuery();
+
+	// Returns the tuning values in use: PresetOverride, Preset, or the defaults, in this order.
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	const FTargetSystemSettings& GetSettings() const;
+
+	// Switches to another shared preset at runtime.
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetPreset(UTargetSystemPreset* InPreset);
+
+	// Sets the tuning values of this component only, in PresetOverride, created on first call. Blueprints that used to
+	// set the tuning variables of the component can get the settings, set the members to change and call this.
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetSettings(const FTargetSystemSettings& InSettings);
+
+	// Removes PresetOverride, going back to the values of Preset.
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void ClearPresetOverride();
+
+	//~ Accessors of the tuning values most often changed at runtime, formerly variables of the component. Setters copy
+	//~ the values in use to PresetOverride on first call, see SetSettings().
+
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	float GetMinimumDistanceToEnable() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetMinimumDistanceToEnable(float InMinimumDistanceToEnable);
+
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	bool GetShouldControlRotation() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetShouldControlRotation(bool bInShouldControlRotation);
+
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	float GetBreakLineOfSightDelay() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetBreakLineOfSightDelay(float InBreakLineOfSightDelay);
+
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	bool GetShouldDrawLockedOnWidget() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetShouldDrawLockedOnWidget(bool bInShouldDrawLockedOnWidget);
+
+	UFUNCTION(BlueprintPure, Category = "Target System")
+	bool GetEnableStickyTarget() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetEnableStickyTarget(bool bInEnableStickyTarget);
+
+	// Returns the lock on simulation state, for rollback / replay systems to save it.
+	const FTargetSystemLockOnState& GetLockOnState() const;
+
+	// Restores a lock on simulation state previously returned by GetLockOnState().
+	//
+	// This only restores the simulation, presentation (widget, events, character rotation mode) is left untouched.
+	void SetLockOnState(const FTargetSystemLockOnState& InLockOnState);
+
 private:
+#if WITH_EDITORONLY_DATA
+	//~ Tuning values saved with the component before presets, moved to PresetOverride on load (see PostLoad)
+
+	UPROPERTY()
+	float MinimumDistanceToEnable_DEPRECATED = 1200.0f;
+
+	UPROPERTY()
+	TSubclassOf<AActor> TargetableActors_DEPRECATED;
+
+	UPROPERTY()
+	TEnumAsByte<ECollisionChannel> TargetableCollisionChannel_DEPRECATED = ECollisionChannel::ECC_Pawn;
+
+	UPROPERTY()
+	bool bShouldControlRotation_DEPRECATED = false;
+
+	UPROPERTY()
+	bool bIgnoreLookInput_DEPRECATED = true;
+
+	UPROPERTY()
+	float BreakLineOfSightDelay_DEPRECATED = 2.0f;
+
+	UPROPERTY()
+	float RotationHalfLife_DEPRECATED = 0.1f;
+
+	UPROPERTY()
+	float StartRotatingThreshold_DEPRECATED = 0.85f;
+
+	UPROPERTY()
+	bool bShouldDrawLockedOnWidget_DEPRECATED = true;
+
+	UPROPERTY()
+	TSubclassOf<UUserWidget> LockedOnWidgetClass_DEPRECATED;
+
+	UPROPERTY()
+	float LockedOnWidgetDrawSize_DEPRECATED = 32.0f;
+
+	UPROPERTY()
+	FName LockedOnWidgetParentSocket_DEPRECATED = FName("spine_03");
+
+	UPROPERTY()
+	FVector LockedOnWidgetRelativeLocation_DEPRECATED = FVector(0.0f, 0.0f, 0.0f);
+
+	UPROPERTY()
+	bool bAdjustPitchBasedOnDistanceToTarget_DEPRECATED = true;
+
+	UPROPERTY()
+	float PitchDistanceCoefficient_DEPRECATED = -0.2f;
+
+	UPROPERTY()
+	float PitchDistanceOffset_DEPRECATED = 60.0f;
+
+	UPROPERTY()
+	float PitchMin_DEPRECATED = -50.0f;
+
+	UPROPERTY()
+	float PitchMax_DEPRECATED = -20.0f;
+
+	UPROPERTY()
+	int32 IgnoredTeamMask_DEPRECATED = 0;
+
+	UPROPERTY()
+	int32 IgnoredFactionMask_DEPRECATED = 0;
+
+	UPROPERTY()
+	FGameplayTagQuery TargetTagQuery_DEPRECATED;
+
+	UPROPERTY()
+	bool bEnableStickyTarget_DEPRECATED = false;
+
+	UPROPERTY()
+	float AxisMultiplier_DEPRECATED = 1.0f;
+
+	UPROPERTY()
+	float StickyRotationThreshold_DEPRECATED = 30.0f;
+#endif
+
 	UPROPERTY()
 	AActor* OwnerActor;
 
@@ -190,47 +316,88 @@ private:
 	UPROPERTY()
 	UWidgetComponent* TargetLockedOnWidgetComponent;
 
-	UPROPERTY(Replicated)
-	AActor* LockedOnTargetActor;
+	UPROPERTY()
+	UTargetSystemSubsystem* TargetSystemSubsystem;
+
+	// Visibility points of the settings, registered in TargetSystemSubsystem.
+	int32 VisibilityPointSet = INDEX_NONE;
+
+	// Registers the targetable class, aim socket and visibility points of the settings in TargetSystemSubsystem.
+	void RegisterSettings();
 
-	FTimerHandle LineOfSightBreakTimerHandle;
-	FTimerHandle SwitchingTargetTimerHandle;
+	// Returns PresetOverride, created from the settings in use when not set yet.
+	UTargetSystemPreset& GetOrCreatePresetOverride();
 
-	bool bIsBreakingLineOfSight = false;
-	bool bIsSwitchingTarget = false;
 	UPROPERTY(Replicated)
-	bool bTargetLocked = false;
+	FTargetSystemLockOnState LockOnState;
+
 	float ClosestTargetDistance = 0.0f;
 
-	bool bDesireToSwitch = false;
-	float StartRotatingStack = 0.0f;
+	// Query set by SetTargetTagQuery(), used instead of the preset TargetTagQuery.
+	TOptional<FGameplayTagQuery> TargetTagQueryOverride;
+
+	// TargetTagQueryOverride or the preset TargetTagQuery, compiled against the Target System Subsystem tag index.
+	FTargetSystemCompiledTagQuery CompiledTargetTagQuery;
+
+	void CompileTargetTagQuery();
 
 	//~ Actors search / trace
 
-	TArray<AActor*> GetAllActorsOfClass(TSubclassOf<AActor> ActorClass) const;
-	TArray<AActor*> FindTargetsInRange(TArray<AActor*> ActorsToLook, float RangeMin, float RangeMax) const;
+	// Targets within range, gathered from the Target System Subsystem partitions once per frame, and shared with the
+	// other components querying from the same place.
+	mutable TSharedPtr<const FTargetSystemCandidateSnapshot> CandidateSnapshot;
+
+	// Returns this frame candidate snapshot, gathered around the owner, candidates below are indices into it.
+	const FTargetSystemCandidateSnapshot* GetCandidateSnapshot() const;
+
+	// Buffers reused by queries below, see FTargetSystemQueryScratchScope.
+	mutable FTargetSystemQueryScratch QueryScratch;
+
+	// Cached trace parameters, only the ignored actors change from one trace to the other.
+	mutable FCollisionQueryParams TraceParams;
+
+	// Removes from Candidates, keeping their order, the ones hidden behind occluders according to the subsystem occlusion
+	// buffer of the owner view point. Does nothing unless bUseOcclusionBuffer is set.
+	void RemoveOccludedCandidates(const FTargetSystemCandidateSnapshot& Snapshot, TArray<int32>& Candidates) const;
+
+	// View occlusion buffers are rasterized from: the player camera, or the owner eyes.
+	void GetOcclusionView(FVector& OutViewLocation, FRotator& OutViewRotation, float& OutFOVDegrees, float& OutAspectRatio) const;
 
-	AActor* FindNearestTarget(TArray<AActor*> Actors) const;
+	// First filter pass: targetable candidates of TargetableActors, without any of the ignored team / faction bits, and matching TargetTagQuery.
+	FTargetSystemCandidateFilter GetCandidateFilter() const;
+	void FindTargetsInRange(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& CandidatesToLook, float RangeMin, float RangeMax, TArray<int32>& OutCandidatesInRange) const;
 
-	bool LineTrace(FHitResult& OutHitResult, const AActor* OtherActor, const TArray<AActor*>& ActorsToIgnore) const;
-	bool LineTraceForActor(const AActor* OtherActor, const TArray<AActor*>& ActorsToIgnore) const;
+	AActor* FindNearestTarget(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& Candidates) const;
 
-	bool ShouldBreakLineOfSight() const;
-	void BreakLineOfSight();
+	void GetTargetingData(const AActor* Actor, FTargetSystemTargetingData& OutTargetingData) const;
 
-	bool IsInViewport(const AActor* TargetActor) const;
+	bool LineTrace(FHitResult& OutHitResult, const FVector& TargetLocation, TArrayView<AActor* const> ActorsToIgnore = {}) const;
+	bool LineTraceForActor(const AActor* OtherActor, const FVector& TargetLocation, TArrayView<AActor* const> ActorsToIgnore = {}) const;
 
-	float GetDistanceFromCharacter(const AActor* OtherActor) const;
+	// Traces the visibility points of OtherActor (TargetLocation, then VisibilityPointSockets and bounds corners) in
+	// order of their past success, up to the first visible one.
+	//
+	// A point is visible when the trace hits OtherActor, or when it hits nothing and bVisibleIfUnobstructed is set.
+	bool TraceVisibilityPoints(const AActor* OtherActor, const FVector& TargetLocation, TArrayView<AActor* const> ActorsToIgnore, bool bVisibleIfUnobstructed) const;
+
+	// Visibility points of OtherActor traced by TraceVisibilityPoints(), most successful first.
+	void GetVisibilityPoints(const AActor* OtherActor, const FVector& TargetLocation, TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>>& OutPoints) const;
+
+	bool ShouldBreakLineOfSight(const FVector& TargetLocation) const;
+
+	bool IsInViewport(const FVector& TargetLocation) const;
+
+	float GetDistanceFromCharacter(const FVector& TargetLocation) const;
 
 
 	//~ Actor rotation
 
-	FRotator GetControlRotationOnTarget(const AActor* OtherActor) const;
-	void SetControlRotationOnTarget(AActor* TargetActor) const;
+	FRotator GetDesiredControlRotationOnTarget(const FVector& TargetLocation) const;
+	void SetControlRotationOnTarget(AActor* TargetActor, const FRotator& ControlRotation) const;
 	void ControlRotation(bool ShouldControlRotation) const;
 
-	float GetAngleUsingCameraRotation(const AActor* ActorToLook) const;
-	float GetAngleUsingCharacterRotation(const AActor* ActorToLook) const;
+	// Location and yaw candidate angles are measured from: the camera, or the character when there is none.
+	void GetAngleViewPoint(FVector& OutViewLocation, float& OutViewYaw) const;
 
 	static FRotator FindLookAtRotation(const FVector Start, const FVector Target);
 
@@ -238,13 +405,107 @@ private:
 
 	void CreateAndAttachTargetLockedOnWidgetComponent(AActor* TargetActor);
 
+	// Keeps LockedOnWidgetClass loaded once requested.
+	TSharedPtr<FStreamableHandle> LockedOnWidgetClassHandle;
+
+	void OnLockedOnWidgetClassLoaded();
+
 	//~ Targeting
 
 	void TargetLockOn(AActor* TargetToLockOn);
-	void ResetIsSwitchingTarget();
-	bool ShouldSwitchTargetActor(float AxisValue);
 
-	static bool TargetIsTargetable(const AActor* Actor);
+	FDelegateHandle TargetabilityChangedHandle;
+
+	void OnTargetabilityChanged(AActor* Target, bool bIsTargetable);
+
+	UFUNCTION()
+	void OnLockedOnTargetDestroyed(AActor* DestroyedActor);
+
+	UFUNCTION()
+	void OnLockedOnTargetEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	void BindLockedOnTargetEvents(AActor* Target);
+	void UnbindLockedOnTargetEvents(AActor* Target);
+
+	FTargetSystemLockOnParams GetLockOnParams() const;
+
+	//~ Asynchronous acquisition
+
+	// Acquisition started by TargetActorAsync(), shared with its task.
+	TSharedPtr<FTargetSystemAcquisition> PendingAcquisition;
+
+	// Bound once, async traces keep a pointer to it until they complete.
+	FTraceDelegate AcquisitionTraceDelegate;
+
+	// Issues the acquisition traces once its task completed, called on Tick.
+	void UpdateAcquisition();
+
+	void OnAcquisitionTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	void CompleteAcquisition(AActor* Target);
+
+	//~ Best candidate
+
+	TWeakObjectPtr<AActor> BestCandidate;
+
+	// Candidates of the scan in progress, nearest first, traced a few per frame from BestCandidateScanIndex.
+	TArray<TWeakObjectPtr<AActor>> BestCandidateScan;
+	int32 BestCandidateScanIndex = INDEX_NONE;
+
+	double NextBestCandidateScanTime = 0.0;
+
+	// Starts a new scan every BestCandidateScanInterval, and traces a budget of its candidates, called on Tick.
+	void UpdateBestCandidate();
+	void StartBestCandidateScan();
+	void SetBestCandidate(AActor* Candidate);
+
+	// Returns the best candidate if it is still targetable, within range, in the viewport and visible.
+	AActor* GetValidatedBestCandidate() const;
+
+	//~ Aim assist
+
+	TWeakObjectPtr<AActor> AimAssistTarget;
+
+	// From 0 (target at the edge of AimAssistRadius) to 1 (target on the crosshair).
+	float AimAssistStrength = 0.0f;
+
+	// Recent line of sight results of aim assist candidates, traced again every AimAssistLineOfSightInterval with
+	// asynchronous traces, the previous result being used until theirs come back.
+	struct FAimAssistLineOfSight
+	{
+		double Time = 0.0;
+		bool bIsKnown = false;
+		bool bIsVisible = false;
+
+		// Traces of the request in flight, issued at RequestTime from TraceStart.
+		int32 NumPendingTraces = 0;
+		double RequestTime = 0.0;
+		FVector TraceStart = FVector::ZeroVector;
+	};
+
+	TMap<TObjectKey<AActor>, FAimAssistLineOfSight> AimAssistLineOfSight;
+
+	// Async traces in flight, with the candidate and visibility point each one tests.
+	TArray<FTraceHandle> AimAssistTraceHandles;
+	TArray<TObjectKey<AActor>> AimAssistTraceCandidates;
+	TArray<int32> AimAssistTracePoints;
+
+	FTraceDelegate AimAssistTraceDelegate;
+
+	// Scores candidates around the crosshair and pulls the control rotation towards the best one, called on Tick.
+	void UpdateAimAssist(float DeltaTime);
+
+	// Returns the last known line of sight to Candidate, requesting new traces when outdated and InOutTraceBudget allows.
+	bool HasAimAssistLineOfSight(AActor* Candidate, const FVector& AimPoint, double CurrentTime, int32& InOutTraceBudget);
+
+	void RequestAimAssistLineOfSight(AActor* Candidate, const FVector& AimPoint, double CurrentTime, FAimAssistLineOfSight& LineOfSight);
+
+	// Forgets about the traces in flight for Candidate, their results are ignored.
+	void CancelAimAssistTraces(const TObjectKey<AActor>& Candidate);
+
+	void OnAimAssistTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	void ResetAimAssistLineOfSight();
 
 	//~ Replication
 	UFUNCTION(Server, Reliable)
@@ -269,9 +530,15 @@ private:
 	 void SetupLocalPlayerController();
 
 protected:
+	//~ UObject interface
+	virtual void PostLoad() override;
+
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the component is removed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 };
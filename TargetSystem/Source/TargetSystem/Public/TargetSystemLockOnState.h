@@ -0,0 +1,118 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TargetSystemRotationSolver.h"
+#include "TargetSystemLockOnState.generated.h"
+
+class AActor;
+
+// Tuning values read by FTargetSystemLockOnState::Step, mirrored from the component properties of the same name.
+struct TARGETSYSTEM_API FTargetSystemLockOnParams
+{
+	float MinimumDistanceToEnable = 1200.0f;
+	float LockOffDistance = 0.0f;
+	float LockOffGraceTime = 0.0f;
+	float RotationHalfLife = 0.1f;
+	float BreakLineOfSightDelay = 2.0f;
+	float StartRotatingThreshold = 0.85f;
+	bool bEnableStickyTarget = false;
+	float AxisMultiplier = 1.0f;
+	float StickyRotationThreshold = 30.0f;
+};
+
+// World queries and player input fed to a single FTargetSystemLockOnState::Step.
+struct TARGETSYSTEM_API FTargetSystemLockOnInput
+{
+	// Axis value used to switch target on this step, only evaluated when bHasSwitchAxisInput is set.
+	float SwitchAxisValue = 0.0f;
+	bool bHasSwitchAxisInput = false;
+
+	// Current control rotation, and the one it should converge to. Only evaluated when bHasDesiredRotation is set.
+	FRotator ControlRotation = FRotator::ZeroRotator;
+	FRotator DesiredRotation = FRotator::ZeroRotator;
+	bool bHasDesiredRotation = false;
+
+	// Distance from the owner to the locked on target, and whether the line of sight to it is currently blocked. Only
+	// evaluated when bHasTargetState is set, steps only feeding axis input leave the range and line of sight timers be.
+	float DistanceToTarget = 0.0f;
+	bool bLineOfSightBlocked = false;
+	bool bHasTargetState = false;
+};
+
+// Decisions taken by a single FTargetSystemLockOnState::Step, for the owner to apply to the world.
+struct TARGETSYSTEM_API FTargetSystemLockOnOutput
+{
+	// New control rotation, only set when bHasControlRotation is true.
+	FRotator ControlRotation = FRotator::ZeroRotator;
+	bool bHasControlRotation = false;
+
+	// Target was kept out of reach for longer than LockOffGraceTime, or out of sight for longer than BreakLineOfSightDelay,
+	// and should be locked off.
+	bool bShouldLockOff = false;
+
+	// Switch axis input passed the thresholds and we're not on switching cooldown.
+	//
+	// The owner is expected to look for a new target in the direction of SwitchAxisValue, and call SwitchTarget() on success.
+	bool bShouldSwitchTarget = false;
+	float SwitchAxisValue = 0.0f;
+};
+
+/**
+ * Lock on state machine of a Target System Component.
+ *
+ * Everything is stored inline with no heap allocation, so the state can be copied around to be saved, restored and
+ * resimulated (rollback, replays) at no cost. Step() only depends on this state, its inputs and the DeltaTime, making
+ * it deterministic for a given sequence of inputs.
+ *
+ * Only the locked on status and target are replicated, the rest is simulated locally.
+ */
+USTRUCT()
+struct TARGETSYSTEM_API FTargetSystemLockOnState
+{
+	GENERATED_BODY()
+
+	// Currently locked on target, if any.
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Target;
+
+	UPROPERTY()
+	bool bTargetLocked = false;
+
+	// Simulation clock, advanced by Step. Cooldowns and grace periods below are timestamps on this clock.
+	double Time = 0.0;
+
+	// Whether we recently switched target, and should wait until SwitchingTargetEndTime before switching again.
+	bool bIsSwitchingTarget = false;
+	bool bDesireToSwitch = false;
+	double SwitchingTargetEndTime = 0.0;
+
+	// Whether line of sight is currently blocked, and the time at which it'll be checked again to lock off the target.
+	bool bIsBreakingLineOfSight = false;
+	double LineOfSightBreakTime = 0.0;
+
+	// Whether the target is currently beyond LockOffDistance, and the time at which it'll be locked off if still is.
+	bool bIsOutOfRange = false;
+	double OutOfRangeLockOffTime = 0.0;
+
+	// Accumulated axis input used for the Sticky Feeling on target switch.
+	float StartRotatingStack = 0.0f;
+
+	FTargetSystemRotationSolver RotationSolver;
+
+	// Returns true when locked on a still valid target.
+	bool IsLocked() const;
+
+	void LockOn(AActor* NewTarget);
+	void LockOff();
+
+	// Locks on NewTarget after a target switch, and starts the switching cooldown.
+	void SwitchTarget(AActor* NewTarget);
+
+	// Advances the state machine by DeltaTime. Use a DeltaTime of 0 to only evaluate input.
+	FTargetSystemLockOnOutput Step(const FTargetSystemLockOnParams& Params, const FTargetSystemLockOnInput& Input, float DeltaTime);
+
+private:
+	bool ShouldSwitchTarget(const FTargetSystemLockOnParams& Params, float AxisValue);
+};
@@ -0,0 +1,72 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "TargetSystemOccluderComponent.generated.h"
+
+class UTargetSystemSubsystem;
+struct FTargetSystemOccluderSet;
+
+UENUM(BlueprintType)
+enum class ETargetSystemOccluderShape : uint8
+{
+	Box,
+	Sphere,
+	Capsule
+};
+
+/**
+ * Cheap analytic stand-in for the geometry of large, static occluders (walls, pillars, rocks), line of sight traces are
+ * tested against before any physics query. A trace crossing an occluder is considered blocked without being issued.
+ *
+ * The shape must fit within the actual geometry: a shape sticking out of it would hide targets that are visible. Shapes
+ * are not collision, and don't replace it.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class TARGETSYSTEM_API UTargetSystemOccluderComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTargetSystemOccluderComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System")
+	ETargetSystemOccluderShape Shape;
+
+	// Half extents of the box, scaled by the component scale.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System", meta = (EditCondition = "Shape == ETargetSystemOccluderShape::Box", EditConditionHides))
+	FVector BoxExtent;
+
+	// Radius of the sphere, scaled by the smallest component scale.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System", meta = (ClampMin = 0, EditCondition = "Shape == ETargetSystemOccluderShape::Sphere", EditConditionHides))
+	float SphereRadius;
+
+	// Radius of the capsule, scaled by the smallest of the component X and Y scales.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System", meta = (ClampMin = 0, EditCondition = "Shape == ETargetSystemOccluderShape::Capsule", EditConditionHides))
+	float CapsuleRadius;
+
+	// Half height of the capsule along the component Z axis, hemispheres included, scaled by the component Z scale.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System", meta = (ClampMin = 0, EditCondition = "Shape == ETargetSystemOccluderShape::Capsule", EditConditionHides))
+	float CapsuleHalfHeight;
+
+	// Adds the shape, in world space, to Occluders.
+	void AddTo(FTargetSystemOccluderSet& Occluders) const;
+
+protected:
+	//~ UActorComponent interface
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+	//~ USceneComponent interface
+	virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+#if WITH_EDITOR
+	//~ UObject interface
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	UTargetSystemSubsystem* GetSubsystem() const;
+};
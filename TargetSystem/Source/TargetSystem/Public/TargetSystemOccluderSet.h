@@ -0,0 +1,55 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Analytic occluder proxies (oriented boxes, spheres and capsules) rays are tested against before any physics trace.
+ *
+ * Shapes are stored as a structure of arrays relative to Origin at float precision, and each shape type is tested in a
+ * single loop over all of its shapes, without early out, for the compiler to vectorize it.
+ *
+ * Proxies are expected to fit within the actual geometry, so that a segment crossing one is blocked for sure. Segments
+ * starting or ending inside a proxy are never considered blocked by it.
+ */
+struct TARGETSYSTEM_API FTargetSystemOccluderSet
+{
+	// Origin shapes are stored relative to.
+	FVector Origin = FVector::ZeroVector;
+
+	// Oriented boxes: center, unit axes and half extents along each of them.
+	TArray<FVector3f> BoxCenters;
+	TArray<FVector3f> BoxAxesX;
+	TArray<FVector3f> BoxAxesY;
+	TArray<FVector3f> BoxAxesZ;
+	TArray<FVector3f> BoxExtents;
+
+	TArray<FVector3f> SphereCenters;
+	TArray<float> SphereRadii;
+
+	// Capsules, as the segment between the centers of their hemispheres, and their radius.
+	TArray<FVector3f> CapsuleStarts;
+	TArray<FVector3f> CapsuleEnds;
+	TArray<float> CapsuleRadii;
+
+	int32 Num() const
+	{
+		return BoxCenters.Num() + SphereCenters.Num() + CapsuleStarts.Num();
+	}
+
+	void Reset(const FVector& NewOrigin);
+
+	void AddBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent);
+	void AddSphere(const FVector& Center, float Radius);
+	void AddCapsule(const FVector& Start, const FVector& End, float Radius);
+
+	// Returns whether the segment from Start to End crosses any of the proxies.
+	bool IsSegmentBlocked(const FVector& Start, const FVector& End) const;
+
+private:
+	FVector3f ToRelative(const FVector& Location) const
+	{
+		return FVector3f(Location - Origin);
+	}
+};
@@ -0,0 +1,75 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FTargetSystemCandidateSnapshot;
+struct FTargetSystemOccluderSet;
+
+/**
+ * Low resolution depth buffer rasterized on the CPU from the occluder proxies of the Target System Subsystem, for the
+ * bounds of every candidate to be tested against it in a single pass before any line of sight trace.
+ *
+ * The view is given explicitly rather than read from a viewport, so that it works the same on dedicated servers and for
+ * AI, with no GPU involved.
+ *
+ * Conservative: occluders only cover the pixels fully within their silhouette, at the depth of their farthest point,
+ * and candidates are only occluded when every pixel their bounds overlap is covered by something nearer. A candidate
+ * that is not occluded may still be blocked by geometry without a proxy, so the trace is still needed.
+ */
+struct TARGETSYSTEM_API FTargetSystemOcclusionBuffer
+{
+	int32 Width = 0;
+	int32 Height = 0;
+
+	// Nearest occluder depth of each pixel, row major. Uncovered pixels are at the largest float.
+	TArray<float> Depths;
+
+	// Frame (GFrameCounter) this buffer was rasterized on.
+	uint64 FrameNumber = 0;
+
+	bool IsValid() const
+	{
+		return Width > 0 && Height > 0;
+	}
+
+	/**
+	 * Sets up the view and clears the buffer.
+	 *
+	 * @param FOVDegrees Horizontal field of view
+	 * @param AspectRatio Width over height of the view, the buffer height being derived from it
+	 * @param InWidth Width of the buffer, in pixels
+	 */
+	void Init(const FVector& ViewLocation, const FRotator& ViewRotation, float FOVDegrees, float AspectRatio, int32 InWidth);
+
+	// Rasterizes every shape of Occluders. Spheres and capsules are rasterized as the largest box fitting within them.
+	void RasterizeOccluders(const FTargetSystemOccluderSet& Occluders);
+
+	// Returns whether the sphere of Center and Radius is fully behind rasterized occluders.
+	bool IsSphereOccluded(const FVector& Center, float Radius) const;
+
+	// Removes from Candidates, keeping their order, the ones whose bounds (aim point and bounding radius) are fully behind
+	// rasterized occluders. Returns the number of candidates removed.
+	int32 RemoveOccluded(const FTargetSystemCandidateSnapshot& Snapshot, TArray<int32>& Candidates) const;
+
+private:
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector3f ViewForward = FVector3f::ForwardVector;
+	FVector3f ViewRight = FVector3f::RightVector;
+	FVector3f ViewUp = FVector3f::UpVector;
+
+	// Pixels per unit of view space X / depth (and Y / depth, pixels being square).
+	float PixelScale = 1.0f;
+
+	// Projects a point given relative to ViewLocation. Returns false for points closer than the near plane.
+	bool Project(const FVector3f& Point, FVector2f& OutPixel, float& OutDepth) const;
+
+	// Rasterizes the oriented box of Center (relative to ViewLocation), unit Axes and half Extent.
+	void RasterizeBox(const FVector3f& Center, const FVector3f (&Axes)[3], const FVector3f& Extent);
+
+	// Fills the pixels fully within the convex polygon Hull, with Depth when nearer than the current one.
+	void FillConvexPolygon(TArrayView<const FVector2f> Hull, float Depth);
+
+	bool IsRelativeSphereOccluded(const FVector3f& Center, float Radius) const;
+};
@@ -0,0 +1,25 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "TargetSystemTypes.h"
+#include "TargetSystemPreset.generated.h"
+
+/**
+ * Tuning values of the Target System Component, shared by every component referencing this preset.
+ *
+ * Components without any preset use the values of the class default object.
+ */
+UCLASS(BlueprintType, EditInlineNew)
+class TARGETSYSTEM_API UTargetSystemPreset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UTargetSystemPreset();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Target System", meta = (ShowOnlyInnerProperties))
+	FTargetSystemSettings Settings;
+};
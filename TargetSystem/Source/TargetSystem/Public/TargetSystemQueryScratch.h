@@ -0,0 +1,43 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Buffers reused by every targeting query of a component, for queries not to allocate once warmed up.
+struct TARGETSYSTEM_API FTargetSystemQueryScratch
+{
+	// Candidates passing the filters, then the visible ones, then the ones within the switch angle range.
+	TArray<int32> Candidates;
+	TArray<int32> VisibleCandidates;
+	TArray<int32> CandidatesInRange;
+
+	TArray<float> DistancesSquared;
+	TArray<float> RelativeDistancesSquared;
+	TArray<float> Angles;
+
+	// Candidate aim points projected to viewport pixels, and their distance to the crosshair.
+	TArray<FVector2f> ScreenLocations;
+	TArray<float> ScreenDistances;
+
+	TArray<AActor*> ActorsToIgnore;
+
+	// Number of queries that had to grow one of the buffers so far.
+	uint32 NumGrowths = 0;
+
+	// Empties every buffer, keeping their allocations.
+	void Reset();
+
+	SIZE_T GetAllocatedSize() const;
+};
+
+// Resets the scratch buffers for a query, and counts the query as a growth if it grew any of them.
+struct TARGETSYSTEM_API FTargetSystemQueryScratchScope
+{
+	explicit FTargetSystemQueryScratchScope(FTargetSystemQueryScratch& InScratch);
+	~FTargetSystemQueryScratchScope();
+
+private:
+	FTargetSystemQueryScratch& Scratch;
+	SIZE_T AllocatedSize;
+};
@@ -0,0 +1,37 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Critically damped spring used to drive the control rotation towards the locked on target.
+ *
+ * The spring is integrated with its exact closed form solution, so it stays stable for any DeltaTime (variable frame
+ * rate, hitches or fixed simulation steps) and the same sequence of DeltaTime values always yields the same sequence of
+ * rotations. Only Pitch and Yaw are integrated, each as a single unwound axis.
+ */
+struct TARGETSYSTEM_API FTargetSystemRotationSolver
+{
+	// Current Pitch angular velocity, in degrees per second.
+	float PitchVelocity = 0.0f;
+
+	// Current Yaw angular velocity, in degrees per second.
+	float YawVelocity = 0.0f;
+
+	// Clears the accumulated velocity, to be called whenever the goal jumps (eg. on target lock on / off).
+	void Reset();
+
+	/**
+	 * Moves Current towards Target.
+	 *
+	 * @param Current The rotation to start from. Its Roll is passed through unchanged.
+	 * @param Target The rotation to converge to.
+	 * @param HalfLife Time in seconds for the spring to cover half of the remaining distance. Snaps to Target when <= 0.
+	 * @param DeltaTime Step duration, in seconds.
+	 */
+	FRotator Step(const FRotator& Current, const FRotator& Target, float HalfLife, float DeltaTime);
+
+	// Steps a single angle (in degrees) towards Goal along the shortest path, returning the normalized result.
+	static float StepAxis(float Value, float& InOutVelocity, float Goal, float HalfLife, float DeltaTime);
+};
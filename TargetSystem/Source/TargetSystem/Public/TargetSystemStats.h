@@ -0,0 +1,42 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("TargetSystem"), STATGROUP_TargetSystem, STATCAT_Advanced);
+
+// Targeting queries (acquisition, switch, line of sight) run this frame.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Targeting Queries"), STAT_TargetSystemQueries, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Targeting queries that had to grow a scratch buffer this frame. Stays at 0 once buffers are warmed up.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scratch Buffer Growths"), STAT_TargetSystemScratchGrowths, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Candidate gathers served by, or missing, the per-frame query cache of the Target System Subsystem.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Gather Cache Hits"), STAT_TargetSystemGatherCacheHits, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Gather Cache Misses"), STAT_TargetSystemGatherCacheMisses, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Line of sight traces served by, or missing, the per-frame query cache.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Line Of Sight Cache Hits"), STAT_TargetSystemLineOfSightCacheHits, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Line Of Sight Cache Misses"), STAT_TargetSystemLineOfSightCacheMisses, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Time spent scoring candidates and applying aim assist this frame, every local player included.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Aim Assist"), STAT_TargetSystemAimAssist, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Line of sight traces aim assist could not reuse a recent result for this frame.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Aim Assist Traces"), STAT_TargetSystemAimAssistTraces, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Line of sight traces rejected by an occluder proxy this frame, without a physics query.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Occluder Rejected Traces"), STAT_TargetSystemOccluderRejections, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Time spent rasterizing and testing candidates against occlusion buffers this frame, and the candidates discarded.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Occlusion Buffer"), STAT_TargetSystemOcclusionBuffer, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Occlusion Buffer Rejected Candidates"), STAT_TargetSystemOcclusionBufferRejections, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Occlusion buffers served by, or rasterized for, the per-frame occlusion buffer cache of the Target System Subsystem.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Occlusion Buffer Cache Hits"), STAT_TargetSystemOcclusionBufferCacheHits, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Occlusion Buffer Cache Misses"), STAT_TargetSystemOcclusionBufferCacheMisses, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+// Line of sight traces reduced to dynamic objects thanks to baked static visibility this frame.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Static Visibility Clear Traces"), STAT_TargetSystemStaticVisibilityClear, STATGROUP_TargetSystem, TARGETSYSTEM_API);
@@ -0,0 +1,481 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayTagContainer.h"
+#include "UObject/ObjectKey.h"
+#include "TargetSystemCandidateSnapshot.h"
+#include "TargetSystemOccluderSet.h"
+#include "TargetSystemOcclusionBuffer.h"
+#include "TargetSystemVisibilityData.h"
+#include "TargetSystemSubsystem.generated.h"
+
+class IGameplayTagAssetInterface;
+class USceneComponent;
+class ITargetSystemTargetableInterface;
+class UTargetSystemOccluderComponent;
+
+// How a Targetable Interface event (targetability, targeting data) of a class of actors is resolved.
+enum class ETargetSystemTargetableDispatch : uint8
+{
+	// Does not implement the event: always targetable, default targeting data.
+	None,
+
+	// Implemented in C++ and not overridden in Blueprints, resolved with a native virtual call.
+	Native,
+
+	// Implemented or overridden in Blueprints, resolved through the event.
+	Script
+};
+
+// Visibility points tested by components with the same settings: the aim point, then sockets, then bounds corners.
+struct TARGETSYSTEM_API FTargetSystemVisibilityPointSet
+{
+	TArray<FName> Sockets;
+	bool bTestBoundsCorners = false;
+	float BoundsCornersScale = 0.5f;
+
+	int32 GetNumPoints() const
+	{
+		return 1 + Sockets.Num() + (bTestBoundsCorners ? 8 : 0);
+	}
+
+	bool operator==(const FTargetSystemVisibilityPointSet& Other) const
+	{
+		return Sockets == Other.Sockets && bTestBoundsCorners == Other.bTestBoundsCorners && BoundsCornersScale == Other.BoundsCornersScale;
+	}
+};
+
+// A visibility point of a target, with its index in the visibility point set.
+struct TARGETSYSTEM_API FTargetSystemVisibilityPoint
+{
+	int32 Index = 0;
+	FVector Location = FVector::ZeroVector;
+};
+
+// A mesh socket resolved once. For skinned meshes, the bone of the socket and the socket transform relative to it: the
+// bone component space transform is read back from the last evaluated pose. For other meshes, the socket transform
+// relative to the mesh.
+struct TARGETSYSTEM_API FTargetSystemResolvedSocket
+{
+	int32 BoneIndex = INDEX_NONE;
+	FTransform Transform;
+	bool bValid = false;
+};
+
+// Visibility points state of a target, for one visibility point set.
+struct TARGETSYSTEM_API FTargetSystemTargetVisibilityPoints
+{
+	int32 Set = INDEX_NONE;
+
+	// Mesh the sockets of the set were resolved on, on first use.
+	TWeakObjectPtr<const USceneComponent> SocketComponent;
+	TArray<FTargetSystemResolvedSocket, TInlineAllocator<4>> Sockets;
+	bool bSocketsResolved = false;
+
+	// Moving average of the visibility test success of each point of the set, see ReportVisibilityPoint.
+	TArray<float, TInlineAllocator<4>> Scores;
+};
+
+// An actor registered in the Target System Subsystem.
+struct TARGETSYSTEM_API FTargetSystemTarget
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	// Registry key, still usable to unregister the actor once it's been garbage collected.
+	TObjectKey<AActor> Key;
+
+	// Interface pointer of native implementers (even when overridden in Blueprints), cached on registration.
+	const ITargetSystemTargetableInterface* NativeInterface = nullptr;
+
+	// Gameplay tags interface pointer, cached on registration.
+	const IGameplayTagAssetInterface* TagAssetInterface = nullptr;
+
+	ETargetSystemTargetableDispatch Dispatch = ETargetSystemTargetableDispatch::None;
+	ETargetSystemTargetableDispatch TargetingDataDispatch = ETargetSystemTargetableDispatch::None;
+
+	// Owned gameplay tags, mirrored over the subsystem tag index whenever the target notifies they changed.
+	FTargetSystemTagBits TagBits;
+
+	// Mesh aim points are taken from, resolved from the aim socket of the target class on first snapshot. Unset to use
+	// the actor location.
+	TWeakObjectPtr<const USceneComponent> AimComponent;
+
+	FTargetSystemResolvedSocket AimSocket;
+	bool bAimSocketResolved = false;
+
+	// Per visibility point set tested against this target, usually one.
+	TArray<FTargetSystemTargetVisibilityPoints, TInlineAllocator<1>> VisibilityPoints;
+
+	// Set once the target published its targetability with NotifyTargetabilityChanged, in which case the published
+	// value is used instead of asking the target.
+	bool bHasPublishedTargetability = false;
+	bool bPublishedTargetable = true;
+};
+
+// Targets of a single level: the persistent level, a streamed sublevel or a World Partition streaming cell.
+struct TARGETSYSTEM_API FTargetSystemPartition
+{
+	TWeakObjectPtr<ULevel> Level;
+
+	// Registered targets. Once the snapshot is taken, its indices match this array ones.
+	TArray<FTargetSystemTarget> Targets;
+	TMap<TObjectKey<AActor>, int32> TargetIndices;
+
+	// Bounds of the targets aim points as of the last refresh, at BoundsTime. Queries pad them with the distance the
+	// fastest target of the last refresh may have covered since, for targets to move around between two refreshes.
+	FBox Bounds = FBox(ForceInit);
+	double BoundsTime = 0.0;
+	float MaxTargetSpeed = 0.0f;
+
+	// Targeting data of Targets, taken at most once per frame, and only when a query reaches this partition.
+	FTargetSystemCandidateSnapshot Snapshot;
+
+	// Set whenever Targets change, to take the snapshot again on next access.
+	bool bSnapshotDirty = true;
+
+	// Set when the tag index grows, to mirror the tags of every target again.
+	bool bTargetTagsDirty = false;
+};
+
+// Hit and miss counts of the per-frame query cache, since the subsystem was initialized.
+struct TARGETSYSTEM_API FTargetSystemQueryCacheStats
+{
+	uint64 GatherHits = 0;
+	uint64 GatherMisses = 0;
+	uint64 LineOfSightHits = 0;
+	uint64 LineOfSightMisses = 0;
+	uint64 OcclusionBufferHits = 0;
+	uint64 OcclusionBufferMisses = 0;
+
+	float GetGatherHitRate() const
+	{
+		return GatherHits + GatherMisses > 0 ? static_cast<float>(GatherHits) / (GatherHits + GatherMisses) : 0.0f;
+	}
+
+	float GetLineOfSightHitRate() const
+	{
+		return LineOfSightHits + LineOfSightMisses > 0 ? static_cast<float>(LineOfSightHits) / (LineOfSightHits + LineOfSightMisses) : 0.0f;
+	}
+
+	float GetOcclusionBufferHitRate() const
+	{
+		return OcclusionBufferHits + OcclusionBufferMisses > 0 ? static_cast<float>(OcclusionBufferHits) / (OcclusionBufferHits + OcclusionBufferMisses) : 0.0f;
+	}
+};
+
+/**
+ * Registry of targetable actors for a World, shared by every Target System Component.
+ *
+ * Actors of the classes components search for are registered once (when spawned or streamed in), along with how their
+ * targetability is resolved, so that queries never iterate the world actors nor go through the reflection system.
+ *
+ * Targets are partitioned by level, World Partition streaming cells included. Partitions are added and removed as a
+ * whole when levels are streamed in and out, and queries only visit the partitions within their radius.
+ *
+ * Query results are cached for the frame by origin cell (TargetSystem.QueryCacheCellSize), so that components querying
+ * from the same place, split screen players or squads of AI, share gathered candidates and line of sight traces.
+ *
+ * Occluder components register their analytic shape here, for line of sight traces crossing one to be rejected without
+ * a physics query. Visibility volumes register their baked static visibility, see UTargetSystemVisibilityData.
+ */
+UCLASS()
+class TARGETSYSTEM_API UTargetSystemSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+protected:
+	//~ UWorldSubsystem interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	// Makes sure actors of ActorClass get registered, and included in the candidate snapshot, with their aim point taken
+	// from AimSocket when set. Aim sockets are set per class, another socket registered for the same class is ignored
+	// with a warning.
+	void RegisterTargetableClass(TSubclassOf<AActor> ActorClass, FName AimSocket = NAME_None);
+
+	/**
+	 * Returns this frame targeting data of the targets in every partition within Radius of Origin, taking partition
+	 * snapshots if not done yet.
+	 *
+	 * Gathered snapshots are shared by every query of the frame from the same origin cell and with the same radius. They
+	 * are rebased on the cell center, and may include candidates slightly further than Radius from Origin.
+	 *
+	 * Release the previous snapshot before gathering again, for its buffers to be reused.
+	 */
+	TSharedRef<const FTargetSystemCandidateSnapshot> GatherCandidates(const FVector& Origin, float Radius);
+
+	/**
+	 * Looks for the result of a line of sight trace from the cell of Origin to Target, traced this frame.
+	 *
+	 * Traces are expected to ignore the querying actor, and at most one other actor, and Target to be visible only when
+	 * one of the points of VisibilityPointSet is hit. Line of sight break checks, visible when unobstructed, are not cached.
+	 *
+	 * @param VisibilityPointSet Points traced, see RegisterVisibilityPointSet()
+	 * @param bOutVisible Whether the trace reached Target, when found
+	 * @return Whether a result was found
+	 */
+	bool FindCachedLineOfSight(const FVector& Origin, const AActor* Target, const AActor* IgnoredActor, ECollisionChannel TraceChannel, int32 VisibilityPointSet, bool& bOutVisible);
+
+	// Caches the result of a line of sight trace for the rest of the frame, see FindCachedLineOfSight().
+	void AddCachedLineOfSight(const FVector& Origin, const AActor* Target, const AActor* IgnoredActor, ECollisionChannel TraceChannel, int32 VisibilityPointSet, bool bVisible);
+
+	// Registers the visibility points of a component settings, returns the index of the set, shared by every component
+	// testing the same points.
+	int32 RegisterVisibilityPointSet(const FTargetSystemVisibilityPointSet& PointSet);
+
+	/**
+	 * Fills OutPoints with the visibility points of Target in Set, most successful first, in set order for targets no
+	 * point was reported for yet.
+	 *
+	 * Sockets are resolved once per target and read back from the last evaluated pose. Sockets missing from the target
+	 * mesh are skipped, only AimPoint is returned for an invalid Set.
+	 */
+	void GetVisibilityPoints(const AActor* Target, int32 Set, const FVector& AimPoint, TArray<FTargetSystemVisibilityPoint, TInlineAllocator<16>>& OutPoints);
+
+	// Reports the result of the visibility test of one of the visibility points of Target in Set.
+	void ReportVisibilityPoint(const AActor* Target, int32 Set, int32 PointIndex, bool bVisible);
+
+	void RegisterOccluder(UTargetSystemOccluderComponent* Occluder);
+	void UnregisterOccluder(UTargetSystemOccluderComponent* Occluder);
+
+	// Rebuilds the occluder set on next query, once an occluder moved or changed.
+	void MarkOccludersDirty()
+	{
+		bOccludersDirty = true;
+	}
+
+	// Returns whether the segment from Start to End crosses a registered occluder, in which case a line of sight trace
+	// along it is blocked for sure. False does not mean the segment is clear.
+	bool IsOccluded(const FVector& Start, const FVector& End);
+
+	// Returns the shapes of the registered occluders, rebuilt first when dirty.
+	const FTargetSystemOccluderSet& GetOccluders();
+
+	/**
+	 * Returns the occluders rasterized from a view, at most once per frame and view: components sharing a view share the
+	 * buffer. The reference is only valid until the next call.
+	 *
+	 * @param FOVDegrees Horizontal field of view
+	 * @param AspectRatio Width over height of the view
+	 */
+	const FTargetSystemOcclusionBuffer& GetOcclusionBuffer(const FVector& ViewLocation, const FRotator& ViewRotation, float FOVDegrees, float AspectRatio);
+
+	void AddStaticVisibility(const UTargetSystemVisibilityData* VisibilityData);
+	void RemoveStaticVisibility(const UTargetSystemVisibilityData* VisibilityData);
+
+	// Returns whether baked static visibility on TraceChannel guarantees no static geometry is between Start and End.
+	bool IsStaticallyClear(const FVector& Start, const FVector& End, ECollisionChannel TraceChannel) const;
+
+	const FTargetSystemQueryCacheStats& GetQueryCacheStats() const
+	{
+		return QueryCacheStats;
+	}
+
+	// Incremented whenever a target is added, removed or changes, for gathered snapshots to know they are outdated.
+	uint32 GetRevision() const
+	{
+		return Revision;
+	}
+
+	// Fills OutTargetingData for Actor, from this frame partition snapshot when registered.
+	void GetTargetingData(const AActor* Actor, FTargetSystemTargetingData& OutTargetingData);
+
+	// Returns whether Actor is currently targetable, registered or not.
+	bool IsTargetable(const AActor* Actor);
+
+	// Returns how the targetability of Class is resolved, cached per class.
+	ETargetSystemTargetableDispatch GetTargetableDispatch(const UClass* Class);
+
+	// Returns how the targeting data of Class is resolved, cached per class.
+	ETargetSystemTargetableDispatch GetTargetingDataDispatch(const UClass* Class);
+
+	// Compiles Query into bitset masks over the tag index, adding the tags it references to the index. Queries that can't
+	// be compiled are kept as is, see FTargetSystemCompiledTagQuery.
+	void CompileTagQuery(const FGameplayTagQuery& Query, FTargetSystemCompiledTagQuery& OutCompiledQuery);
+
+private:
+	// Sparse, for partitions to be added and removed without moving the other ones.
+	TSparseArray<FTargetSystemPartition> Partitions;
+	TMap<TObjectKey<ULevel>, int32> PartitionIndices;
+
+	struct FPendingLevel
+	{
+		TWeakObjectPtr<ULevel> Level;
+
+		// Bounds of the level Level Bounds actor, invalid when it has none.
+		FBox Bounds = FBox(ForceInit);
+	};
+
+	// Levels streamed in whose actors are not registered yet. Registration is spread over several frames, for dense
+	// cells not to cause a hitch, unless a query reaches the level first.
+	TArray<FPendingLevel> PendingLevels;
+	int32 PendingLevelActorIndex = 0;
+
+	uint32 Revision = 0;
+
+	// Frame the pending levels and partition bounds were last updated on.
+	uint64 RegistryUpdateFrameNumber = 0;
+
+	// Partition whose bounds get refreshed next, round robin.
+	int32 NextBoundsRefreshPartition = 0;
+
+	//~ Per-frame query cache
+
+	struct FGatherCacheEntry
+	{
+		FIntVector Cell;
+		float Radius = 0.0f;
+		TSharedPtr<FTargetSystemCandidateSnapshot> Snapshot;
+	};
+
+	struct FLineOfSightKey
+	{
+		FIntVector Cell;
+		FObjectKey Target;
+		FObjectKey IgnoredActor;
+		ECollisionChannel TraceChannel;
+
+		// Components with different visibility points may disagree on the same target
+		int32 VisibilityPointSet;
+
+		bool operator==(const FLineOfSightKey& Other) const
+		{
+			return Cell == Other.Cell && Target == Other.Target && IgnoredActor == Other.IgnoredActor && TraceChannel == Other.TraceChannel
+				&& VisibilityPointSet == Other.VisibilityPointSet;
+		}
+
+		friend uint32 GetTypeHash(const FLineOfSightKey& Key)
+		{
+			const uint32 Hash = HashCombine(HashCombine(GetTypeHash(Key.Cell), GetTypeHash(Key.Target)), HashCombine(GetTypeHash(Key.IgnoredActor), static_cast<uint32>(Key.TraceChannel)));
+			return HashCombine(Hash, GetTypeHash(Key.VisibilityPointSet));
+		}
+	};
+
+	TArray<FGatherCacheEntry> GatherCache;
+
+	// Gathered snapshots of previous frames, reused once no component holds them anymore.
+	TArray<TSharedPtr<FTargetSystemCandidateSnapshot>> GatherSnapshotPool;
+
+	TMap<FLineOfSightKey, bool> LineOfSightCache;
+
+	struct FOcclusionBufferEntry
+	{
+		FVector ViewLocation = FVector::ZeroVector;
+		FRotator ViewRotation = FRotator::ZeroRotator;
+		float FOVDegrees = 0.0f;
+		float AspectRatio = 0.0f;
+		int32 Width = 0;
+		FTargetSystemOcclusionBuffer Buffer;
+	};
+
+	// Occlusion buffers rasterized this frame, the ones of previous frames being reused for their allocation. Rasterized
+	// again once the occluders changed.
+	TArray<FOcclusionBufferEntry> OcclusionBufferCache;
+
+	// Frame and revision cached query results are valid for.
+	uint64 QueryCacheFrameNumber = 0;
+	uint32 QueryCacheRevision = 0;
+
+	FTargetSystemQueryCacheStats QueryCacheStats;
+
+	//~ Occluders
+
+	TArray<TWeakObjectPtr<UTargetSystemOccluderComponent>> OccluderComponents;
+
+	// Shapes of OccluderComponents, rebuilt on query whenever dirty.
+	FTargetSystemOccluderSet Occluders;
+	bool bOccludersDirty = false;
+
+	// Visibility points of component settings, see RegisterVisibilityPointSet().
+	TArray<FTargetSystemVisibilityPointSet> VisibilityPointSets;
+
+	// Baked static visibility of the visibility volumes in play, kept loaded by the volumes.
+	TArray<TWeakObjectPtr<const UTargetSystemVisibilityData>> StaticVisibilityData;
+
+	// Classes searched for by components so far, actors of any of these classes get registered.
+	UPROPERTY()
+	TArray<TSubclassOf<AActor>> TargetableClasses;
+
+	// Aim socket of each of TargetableClasses, NAME_None to use the actor location.
+	TArray<FName> TargetableClassAimSockets;
+
+	// Ignored aim sockets of TargetableClasses, only warned about once.
+	TSet<TPair<FObjectKey, FName>> IgnoredAimSockets;
+
+	TMap<FObjectKey, ETargetSystemTargetableDispatch> DispatchCache;
+	TMap<FObjectKey, ETargetSystemTargetableDispatch> TargetingDataDispatchCache;
+
+	// Every tag referenced by a compiled query, with its bit index in FTargetSystemTagBits.
+	TArray<FGameplayTag> IndexedTags;
+	TMap<FGameplayTag, int32> TagIndices;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle ActorDestroyedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+	FDelegateHandle TargetabilityChangedHandle;
+	FDelegateHandle GameplayTagsChangedHandle;
+
+	bool IsRegisteredClass(const AActor* Actor) const;
+
+	void RegisterActor(AActor* Actor);
+	void UnregisterActor(const AActor* Actor);
+	void RemoveTargetAt(FTargetSystemPartition& Partition, int32 Index);
+
+	FTargetSystemPartition* FindPartition(const AActor* Actor);
+	FTargetSystemTarget* FindTarget(const AActor* Actor);
+	FTargetSystemPartition& FindOrAddPartition(ULevel* Level);
+	void RemovePartition(ULevel* Level);
+	static void RefreshPartitionBounds(FTargetSystemPartition& Partition, double Time);
+
+	// Once per frame, registers a budget of actors from pending levels and refreshes the bounds of one partition.
+	void UpdateRegistry();
+
+	// Registers right away the actors of pending levels within Radius of Origin, and of those with unknown bounds.
+	void RegisterPendingLevels(const FVector& Origin, float Radius);
+	void RegisterLevelActors(const ULevel& Level, int32 StartIndex, int32 EndIndex);
+
+	static bool IsTargetable(const FTargetSystemTarget& Target, const AActor* Actor);
+	FTargetSystemTargetingData GetTargetingData(FTargetSystemTarget& Target, const AActor* Actor) const;
+
+	FName GetAimSocket(const AActor* Actor) const;
+	void ResolveAimSocket(FTargetSystemTarget& Target, const AActor* Actor) const;
+	static bool GetSocketAimPoint(const FTargetSystemTarget& Target, FVector& OutAimPoint);
+
+	static FTargetSystemTargetVisibilityPoints& FindOrAddVisibilityPoints(FTargetSystemTarget& Target, int32 Set);
+	void ResolveVisibilitySockets(FTargetSystemTargetVisibilityPoints& Points, const AActor* Actor) const;
+
+	// Resolves the aim and visibility sockets of every target again, once the aim socket of a class changed.
+	void InvalidateAimSockets();
+
+	// Returns this frame snapshot of Partition, taking it if not done yet.
+	const FTargetSystemCandidateSnapshot& GetPartitionSnapshot(FTargetSystemPartition& Partition);
+	void TakePartitionSnapshot(FTargetSystemPartition& Partition);
+
+	int32 GetOrAddTagIndex(const FGameplayTag& Tag);
+	bool CompileTagQueryExpression(const FGameplayTagQueryExpression& Expression, int32 NodeIndex, FTargetSystemCompiledTagQuery& OutCompiledQuery);
+	void MirrorTargetTags(FTargetSystemTarget& Target) const;
+
+	// Clears cached query results on a new frame, or once a target changed.
+	void UpdateQueryCache();
+	TSharedPtr<FTargetSystemCandidateSnapshot> AllocateGatherSnapshot();
+	static bool GetQueryCacheCell(const FVector& Location, FIntVector& OutCell);
+
+	void RebuildOccluders();
+
+	void OnActorSpawned(AActor* Actor);
+	void OnActorDestroyed(AActor* Actor);
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+	void OnTargetabilityChanged(AActor* Actor, bool bIsTargetable);
+	void OnGameplayTagsChanged(AActor* Actor);
+};
@@ -0,0 +1,101 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+class AActor;
+
+// Maximum number of distinct tags referenced by the tag queries of a World.
+static constexpr int32 TargetSystemMaxIndexedTags = 256;
+
+// Fixed size bitset over the tag index of the Target System Subsystem, one bit per indexed tag.
+struct TARGETSYSTEM_API FTargetSystemTagBits
+{
+	static constexpr int32 NumWords = TargetSystemMaxIndexedTags / 64;
+
+	uint64 Words[NumWords] = {};
+
+	void SetBit(const int32 Index)
+	{
+		Words[Index >> 6] |= 1ull << (Index & 63);
+	}
+
+	bool HasAny(const FTargetSystemTagBits& Mask) const
+	{
+		uint64 Result = 0;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Result |= Words[Word] & Mask.Words[Word];
+		}
+		return Result != 0;
+	}
+
+	bool HasAll(const FTargetSystemTagBits& Mask) const
+	{
+		uint64 Missing = 0;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Missing |= Mask.Words[Word] & ~Words[Word];
+		}
+		return Missing == 0;
+	}
+};
+
+/**
+ * FGameplayTagQuery compiled into bitset masks over the tag index of the Target System Subsystem.
+ *
+ * Target tags are mirrored into the registry as FTargetSystemTagBits (hierarchy included, a target owning A.B has the
+ * bit of A set), so matching a candidate only takes bitwise operations.
+ *
+ * Queries that can't be compiled (eg. exact matches, or too many tags) are kept as is, and matched with
+ * FGameplayTagQuery::Matches against the owned tags of the target instead, on the game thread only.
+ */
+struct TARGETSYSTEM_API FTargetSystemCompiledTagQuery
+{
+	struct FNode
+	{
+		EGameplayTagQueryExprType Type = EGameplayTagQueryExprType::Undefined;
+
+		// Tags of AnyTagsMatch / AllTagsMatch / NoTagsMatch expressions.
+		FTargetSystemTagBits Mask;
+
+		// Sub expressions of AnyExprMatch / AllExprMatch / NoExprMatch expressions, stored contiguously.
+		int32 FirstChild = INDEX_NONE;
+		int32 NumChildren = 0;
+	};
+
+	// Nodes[0] is the root expression. An empty query matches everything.
+	TArray<FNode, TInlineAllocator<4>> Nodes;
+
+	// Set instead of Nodes when the query could not be compiled.
+	TOptional<FGameplayTagQuery> UncompiledQuery;
+
+	bool IsEmpty() const
+	{
+		return Nodes.Num() == 0 && !UncompiledQuery.IsSet();
+	}
+
+	bool IsCompiled() const
+	{
+		return !UncompiledQuery.IsSet();
+	}
+
+	// Matches the mirrored tags of a target, or the owned tags of Actor when the query could not be compiled.
+	bool Matches(const FTargetSystemTagBits& TagBits, const AActor* Actor) const
+	{
+		if (!IsCompiled())
+		{
+			return MatchesOwnedTags(Actor);
+		}
+
+		return Nodes.Num() == 0 || Matches(0, TagBits);
+	}
+
+	// Matches UncompiledQuery against the owned tags of Actor, game thread only.
+	bool MatchesOwnedTags(const AActor* Actor) const;
+
+private:
+	bool Matches(int32 NodeIndex, const FTargetSystemTagBits& TagBits) const;
+};
@@ -4,8 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "TargetSystemTypes.h"
 #include "TargetSystemTargetableInterface.generated.h"
 
+DECLARE_MULTICAST_DELEGATE_TwoParams(FTargetSystemTargetabilityChanged, AActor* /* Target */, bool /* bIsTargetable */);
+DECLARE_MULTICAST_DELEGATE_OneParam(FTargetSystemGameplayTagsChanged, AActor* /* Target */);
+
 // This class does not need to be modified.
 UINTERFACE(Blueprintable)
 class UTargetSystemTargetableInterface : public UInterface
@@ -22,6 +26,49 @@ class TARGETSYSTEM_API ITargetSystemTargetableInterface
 
 	// Add interface functions to this class. This is the class that will be inherited to implement this interface.
 public:
+	// Whether this actor can currently be targeted.
+	//
+	// Whenever the returned value changes, implementers must call NotifyTargetabilityChanged (or
+	// UTargetSystemComponent::NotifyTargetabilityChanged from Blueprints) so that components locked on it can react.
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Target System")
 	bool IsTargetable() const;
+
+	// Returns true, actors implementing the interface being targetable unless they say otherwise.
+	virtual bool IsTargetable_Implementation() const;
+
+	// Native fast path used by the Target System in place of the IsTargetable event, unless it is overridden in Blueprints.
+	//
+	// Defaults to calling IsTargetable_Implementation directly, without going through the reflected event, so C++
+	// implementers only need to override IsTargetable_Implementation.
+	virtual bool IsTargetableNative() const;
+
+	// Bulk query for everything the Target System needs to know about this target, called once per frame.
+	//
+	// DefaultTargetingData comes filled with defaults computed from the actor (location, root component bounds, aim
+	// socket). Return it with any value to override (aim point, priority, team, widget socket, ...).
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Target System")
+	FTargetSystemTargetingData GetTargetingData(const FTargetSystemTargetingData& DefaultTargetingData) const;
+
+	// Returns DefaultTargetingData as is, for targets only implementing IsTargetable to keep the defaults.
+	virtual FTargetSystemTargetingData GetTargetingData_Implementation(const FTargetSystemTargetingData& DefaultTargetingData) const;
+
+	// Native fast path used by the Target System in place of the GetTargetingData event, unless it is overridden in
+	// Blueprints.
+	//
+	// Defaults to calling GetTargetingData_Implementation directly, leaving InOutTargetingData untouched unless it is
+	// overridden.
+	virtual void GetTargetingDataNative(FTargetSystemTargetingData& InOutTargetingData) const;
+
+	// Broadcasts the change of targetability of Target to every listener of OnTargetabilityChanged().
+	static void NotifyTargetabilityChanged(AActor* Target, bool bIsTargetable);
+
+	// Native event broadcast whenever a targetable actor changes its targetability.
+	static FTargetSystemTargetabilityChanged& OnTargetabilityChanged();
+
+	// Broadcasts that the gameplay tags owned by Target (see IGameplayTagAssetInterface) changed, for the Target System
+	// to mirror them again.
+	static void NotifyGameplayTagsChanged(AActor* Target);
+
+	// Native event broadcast whenever a target changes its owned gameplay tags.
+	static FTargetSystemGameplayTagsChanged& OnGameplayTagsChanged();
 };
@@ -0,0 +1,286 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "GameplayTagContainer.h"
+#include "TargetSystemTypes.generated.h"
+
+class UUserWidget;
+
+// Everything the Target System needs to know about a target, fetched once per target per frame.
+USTRUCT(BlueprintType)
+struct TARGETSYSTEM_API FTargetSystemTargetingData
+{
+	GENERATED_BODY()
+
+	// World location to aim at, trace to and measure distances from. Defaults to the actor location.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	FVector AimPoint = FVector::ZeroVector;
+
+	// Radius of the target bounding sphere. Defaults to the root component bounds.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float BoundingRadius = 0.0f;
+
+	// Higher priority targets are preferred over lower priority ones, whatever their distance: candidates are ranked by
+	// priority first, then by distance (to the crosshair for aim assist).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float Priority = 0.0f;
+
+	// Teams the target belongs to, one bit per team. Matched against the component IgnoredTeamMask.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System", meta = (Bitmask))
+	int32 TeamBits = 0;
+
+	// Factions the target belongs to, one bit per faction. Matched against the component IgnoredFactionMask.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System", meta = (Bitmask))
+	int32 FactionBits = 0;
+
+	// The Socket name to attach the LockedOn Widget to. When None, the component LockedOnWidgetParentSocket is used.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	FName WidgetSocket = NAME_None;
+
+	// Returns the default targeting data of Actor, computed from its location and root component bounds.
+	static FTargetSystemTargetingData MakeDefault(const AActor* Actor);
+
+	// Packs team bits (low 32 bits) and faction bits (high 32 bits) together, for them to be filtered with a single AND.
+	static uint64 MakeRelationBits(const int32 InTeamBits, const int32 InFactionBits)
+	{
+		return (static_cast<uint64>(static_cast<uint32>(InFactionBits)) << 32) | static_cast<uint32>(InTeamBits);
+	}
+};
+
+// Tuning values of the Target System Component, held by a UTargetSystemPreset.
+USTRUCT(BlueprintType)
+struct TARGETSYSTEM_API FTargetSystemSettings
+{
+	GENERATED_BODY()
+
+	// The minimum distance to enable target locked on.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float MinimumDistanceToEnable = 1200.0f;
+
+	// Distance beyond which a locked on target is locked off. Set it higher than MinimumDistanceToEnable for targets
+	// moving around the acquire distance not to be locked on and off repeatedly. Values below MinimumDistanceToEnable
+	// (the default) lock off as soon as the target is out of MinimumDistanceToEnable.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float LockOffDistance = 0.0f;
+
+	// Seconds a locked on target must stay beyond LockOffDistance before being locked off.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System", meta = (ClampMin = "0.0"))
+	float LockOffGraceTime = 0.0f;
+
+	// The AActor Subclass to search for targetable Actors.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	TSubclassOf<AActor> TargetableActors;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	TEnumAsByte<ECollisionChannel> TargetableCollisionChannel = ECollisionChannel::ECC_Pawn;
+
+	// Whether or not the character rotation should be controlled when Target is locked on.
+	//
+	// If true, it'll set the value of bUseControllerRotationYaw and bOrientationToMovement variables on Target locked on / off.
+	//
+	// Set it to true if you want the character to rotate around the locked on target to enable you to setup strafe animations.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	bool bShouldControlRotation = false;
+
+	// Whether to accept pitch input when bAdjustPitchBasedOnDistanceToTarget is disabled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	bool bIgnoreLookInput = true;
+
+	// The amount of time to break line of sight when actor gets behind an Object.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float BreakLineOfSightDelay = 2.0f;
+
+	// Time in seconds for the control rotation to cover half of the remaining distance to the target rotation.
+	//
+	// The rotation is driven by a critically damped spring, so the result does not depend on the frame rate. Set it to 0 to snap.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float RotationHalfLife = 0.1f;
+
+	// Lower this value is, easier it will be to switch new target on right or left. Must be < 1.0f if controlling with gamepad stick
+	//
+	// When using Sticky Feeling feature, it has no effect (see StickyRotationThreshold)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	float StartRotatingThreshold = 0.85f;
+
+	// Whether or not the Target LockOn Widget indicator should be drawn and attached automatically.
+	//
+	// When set to false, this allow you to manually draw the widget for further control on where you'd like it to appear.
+	//
+	// OnTargetLockedOn and OnTargetLockedOff events can be used for this.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
+	bool bShouldDrawLockedOnWidget = true;
+
+	// The Widget Class to use when locked on Target. If not defined, will fallback to a Text-rendered
+	// widget with a single O character.
+	//
+	// Loaded asynchronously the first time a locally controlled component locks on, never on dedicated servers.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
+	TSoftClassPtr<UUserWidget> LockedOnWidgetClass;
+
+	// The Widget Draw Size for the Widget class to use when locked on Target.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
+	float LockedOnWidgetDrawSize = 32.0f;
+
+	// The Socket name to attach the LockedOn Widget.
+	//
+	// You should use this to configure the Bone or Socket name the widget should be attached to, and allow
+	// the widget to move with target character's animation (Ex: spine_03)
+	//
+	// Set it to None to attach the Widget Component to the AimPointSocket when set, to the Root Component otherwise.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
+	FName LockedOnWidgetParentSocket = FName("spine_03");
+
+	// The Socket (or Bone) name of the target mesh aim points are taken from, instead of the actor location. Line of
+	// sight traces and control rotation then use this point, as well as the LockedOn Widget when LockedOnWidgetParentSocket
+	// is None.
+	//
+	// Set per class of TargetableActors: when several presets target the same class, the first socket registered is used
+	// and the others are ignored with a warning.
+	// Targets implementing GetTargetingData can still override their aim point.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+	FName AimPointSocket = NAME_None;
+
+	// Sockets (or Bones) of the target mesh also tested for visibility when the aim point is blocked (Ex: head, pelvis),
+	// for targets partly behind cover to be considered visible.
+	//
+	// Points are tested in order of their past success rate for each target, up to the first visible one.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility")
+	TArray<FName> VisibilityPointSockets;
+
+	// Whether to also test the corners of the target bounds for visibility, after VisibilityPointSockets.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility")
+	bool bTestBoundsCorners = false;
+
+	// Fraction of the target bounds extent corners are tested at, for them to fall within the target rather than next to it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bTestBoundsCorners"))
+	float BoundsCornersScale = 0.5f;
+
+	// Whether to only consider targets rendered recently (by any view), discarding off camera or fully occluded targets
+	// before any line of sight trace. Targets without any rendered primitive are never considered.
+	//
+	// Always disabled on dedicated servers, which render nothing.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility")
+	bool bOnlyTargetRecentlyRendered = false;
+
+	// Seconds since a target was last rendered for it to still be considered, at least a frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility", meta = (ClampMin = "0.0", EditCondition = "bOnlyTargetRecentlyRendered"))
+	float RecentlyRenderedTolerance = 0.2f;
+
+	// Whether to rasterize the occluder components of the world into a low resolution depth buffer from the owner view
+	// point, once per frame, and discard the candidates fully hidden behind them before any line of sight trace.
+	//
+	// Meant for crowds of candidates behind large occluders. Works without a viewport, for AI and dedicated servers.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Visibility")
+	bool bUseOcclusionBuffer = false;
+
+	// The Relative Location to apply on Target LockedOn Widget when attached to a target.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Widget")
+	FVector LockedOnWidgetRelativeLocation = FVector(0.0f, 0.0f, 0.0f);
+
+	// Setting this to true will tell the Target System to adjust the Pitch Offset (the Y axis) when locked on,
+	// depending on the distance to the target actor.
+	//
+	// It will ensure that the Camera will be moved up vertically the closer this Actor gets to its target.
+	//
+	// Formula:
+	//
+	//   (DistanceToTarget * PitchDistanceCoefficient + PitchDistanceOffset) * -1.0f
+	//
+	// Then Clamped by PitchMin / PitchMax
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
+	bool bAdjustPitchBasedOnDistanceToTarget = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
+	float PitchDistanceCoefficient = -0.2f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
+	float PitchDistanceOffset = 60.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
+	float PitchMin = -50.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Pitch Offset")
+	float PitchMax = -20.0f;
+
+	// Teams whose members can't be targeted (eg. allies and neutrals). Targets are ignored when any of their TeamBits is set here.
+	//
+	// Team and faction masks are tested with a single AND on the candidate snapshot, before any distance, viewport or trace test.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Teams", meta = (Bitmask))
+	int32 IgnoredTeamMask = 0;
+
+	// Factions whose members can't be targeted. Targets are ignored when any of their FactionBits is set here.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Teams", meta = (Bitmask))
+	int32 IgnoredFactionMask = 0;
+
+	// Gameplay tag query targets must match (eg. not State.Dead), matched against the tags of actors implementing
+	// IGameplayTagAssetInterface. Empty matches every target.
+	//
+	// Compiled into bitset masks on BeginPlay, use SetTargetTagQuery() on the component to change it at runtime.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Tags")
+	FGameplayTagQuery TargetTagQuery;
+
+	// Set it to true / false whether you want a sticky feeling when switching target
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
+	bool bEnableStickyTarget = false;
+
+	// This value gets multiplied to the AxisValue to check against StickyRotationThreshold.
+	//
+	// Only used when Sticky Target is enabled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
+	float AxisMultiplier = 1.0f;
+
+	// Lower this value is, easier it will be to switch new target on right or left.
+	//
+	// This is similar to StartRotatingThreshold, but you should set this to a much higher value.
+	//
+	// Only used when Sticky Target is enabled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Sticky Feeling on Target Switch")
+	float StickyRotationThreshold = 30.0f;
+
+	// Keeps the target TargetActor would lock on up to date while not locked on, for lock on to commit right away after
+	// a single validation trace, and for the game to highlight it (see OnBestCandidateChanged).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Best Candidate")
+	bool bMaintainBestCandidate = false;
+
+	// Seconds between two best candidate scans.
+	//
+	// Only used when bMaintainBestCandidate is enabled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Best Candidate", meta = (ClampMin = "0.0"))
+	float BestCandidateScanInterval = 0.2f;
+
+	// Maximum number of line traces per frame a best candidate scan is spread over, nearest candidates first.
+	//
+	// Only used when bMaintainBestCandidate is enabled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Best Candidate", meta = (ClampMin = "1"))
+	int32 BestCandidateTracesPerFrame = 2;
+
+	// Soft lock aim assist while not locked on: pulls the control rotation of local players towards the visible
+	// candidate nearest to the crosshair, and reports how much look input should be slowed down (see GetAimAssistInputScale).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist")
+	bool bEnableAimAssist = false;
+
+	// Radius around the crosshair candidates are assisted within, as a fraction of the viewport height.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float AimAssistRadius = 0.1f;
+
+	// Maximum speed, in degrees per second, the control rotation is pulled towards the assisted target at. Scaled down
+	// the further the target is from the crosshair. 0 to only slow down look input.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist", meta = (ClampMin = "0.0"))
+	float AimAssistMagnetism = 20.0f;
+
+	// How much look input should be slowed down with the assisted target on the crosshair, from 0 (not at all) to 1.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float AimAssistSlowdown = 0.4f;
+
+	// Seconds a candidate line of sight trace result is reused for.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist", meta = (ClampMin = "0.0"))
+	float AimAssistLineOfSightInterval = 0.15f;
+
+	// Maximum number of candidates whose line of sight traces are issued per frame, nearest to the crosshair first.
+	// Traces are asynchronous, candidates keep their previous result until theirs come back the next frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System|Aim Assist", meta = (ClampMin = "1"))
+	int32 AimAssistTracesPerFrame = 1;
+};
@@ -0,0 +1,28 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+struct FTargetSystemCandidateSnapshot;
+
+// Player view projection captured on the game thread, for points to be tested against the viewport from any thread.
+struct TARGETSYSTEM_API FTargetSystemViewProjection
+{
+	FMatrix ViewProjectionMatrix = FMatrix::Identity;
+	FIntRect ViewRect;
+	FVector2D ViewportSize = FVector2D::ZeroVector;
+
+	// Unset without a local player, in which case every point is considered in the viewport.
+	bool bIsValid = false;
+
+	void Capture(const APlayerController* PlayerController);
+
+	// Returns whether WorldLocation is in front of the view, and projects within the viewport.
+	bool IsInViewport(const FVector& WorldLocation) const;
+
+	// Projects the aim point of each of Candidates to viewport pixels in a single pass, points behind the view being
+	// projected outside of the viewport. Requires a valid projection.
+	void ProjectCandidates(const FTargetSystemCandidateSnapshot& Snapshot, const TArray<int32>& Candidates, TArray<FVector2f>& OutScreenLocations) const;
+};
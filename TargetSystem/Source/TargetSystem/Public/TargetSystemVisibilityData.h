@@ -0,0 +1,72 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "TargetSystemVisibilityData.generated.h"
+
+/**
+ * Cell to cell static visibility of a level, baked for a Target System Visibility Volume by the TargetSystemEditor
+ * module (TargetSystem.BakeVisibility console command, or TargetSystemBakeVisibility commandlet), for line of sight checks to only trace dynamic objects where static geometry
+ * is known not to be in the way.
+ *
+ * The volume is split in cubic cells. For each cell, one bit per cell within MaxDistance tells whether the pair of
+ * cells is statically clear, and is only stored once per pair of cells: pairs are symmetric.
+ *
+ * A pair is clear when a box the size of a cell swept from one cell to the other hits no static geometry. The sweep
+ * covers every segment from any point of one cell to any point of the other, so that a clear pair guarantees no static
+ * geometry blocks a trace between them, however thin. Pairs are never baked as blocked, sampled traces can not prove it.
+ *
+ * Targets must be movable for traces of clear pairs, which only query dynamic objects, to hit them.
+ */
+UCLASS(BlueprintType)
+class TARGETSYSTEM_API UTargetSystemVisibilityData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 PairsPerWord = 32;
+
+	// Min corner of the baked bounds.
+	UPROPERTY(VisibleAnywhere, Category = "Target System")
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Target System")
+	float CellSize = 0.0f;
+
+	// Number of cells along each axis.
+	UPROPERTY(VisibleAnywhere, Category = "Target System")
+	FIntVector Dimensions = FIntVector::ZeroValue;
+
+	// Number of cells along each axis visibility is stored for, around each cell.
+	UPROPERTY(VisibleAnywhere, Category = "Target System")
+	FIntVector CellRadius = FIntVector::ZeroValue;
+
+	// Channel static geometry was swept against. Only line of sight checks on the same channel use this data.
+	UPROPERTY(VisibleAnywhere, Category = "Target System")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Pawn;
+
+	// One bit per pair of cells, set for statically clear pairs, see GetPairIndex().
+	UPROPERTY()
+	TArray<uint32> ClearPairBits;
+
+	// Returns whether no static geometry blocks any segment between the cells of Start and End.
+	bool IsStaticallyClear(const FVector& Start, const FVector& End) const;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return ClearPairBits.GetAllocatedSize();
+	}
+
+	// Number of offsets in the box of CellRadius around a cell, the zero offset included.
+	int32 GetNumOffsets() const;
+
+private:
+	bool GetCell(const FVector& Location, FIntVector& OutCell) const;
+
+	// Index in ClearPairBits (counted in bits) of the pair of cells From and To, INDEX_NONE when not stored. Only offsets
+	// after the zero one in linear order are stored for each cell, the other ones being looked up from To.
+	int32 GetPairIndex(const FIntVector& From, const FIntVector& To) const;
+};
@@ -0,0 +1,48 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Volume.h"
+#include "TargetSystemVisibilityVolume.generated.h"
+
+class UTargetSystemVisibilityData;
+
+/**
+ * Bounds the static visibility of a level is baked for, into VisibilityData. Once baked, line of sight checks between
+ * two cells static geometry can not block only trace dynamic objects.
+ *
+ * Bake in editor with the TargetSystem.BakeVisibility console command, or with the TargetSystemBakeVisibility
+ * commandlet, both from the TargetSystemEditor module. Bake again whenever static geometry changes.
+ */
+UCLASS()
+class TARGETSYSTEM_API ATargetSystemVisibilityVolume : public AVolume
+{
+	GENERATED_BODY()
+
+public:
+	ATargetSystemVisibilityVolume();
+
+	// Asset the visibility is baked into. Created next to the level by the commandlet when not set.
+	UPROPERTY(EditAnywhere, Category = "Target System")
+	UTargetSystemVisibilityData* VisibilityData;
+
+	// Size of the cells visibility is baked between. Smaller cells find more clear pairs next to static geometry, at the
+	// cost of a larger asset.
+	UPROPERTY(EditAnywhere, Category = "Target System", meta = (ClampMin = "50.0"))
+	float CellSize;
+
+	// Distance up to which the visibility between two cells is baked, usually the largest MinimumDistanceToEnable or
+	// LockOffDistance of the Target System Components.
+	UPROPERTY(EditAnywhere, Category = "Target System", meta = (ClampMin = "0.0"))
+	float MaxDistance;
+
+	// Must match the TargetableCollisionChannel of the Target System Components.
+	UPROPERTY(EditAnywhere, Category = "Target System")
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+protected:
+	//~ AActor interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
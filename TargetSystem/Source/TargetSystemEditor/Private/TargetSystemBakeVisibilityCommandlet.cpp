@@ -0,0 +1,103 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemBakeVisibilityCommandlet.h"
+#include "EngineUtils.h"
+#include "TargetSystemLog.h"
+#include "TargetSystemVisibilityBaker.h"
+#include "TargetSystemVisibilityData.h"
+#include "TargetSystemVisibilityVolume.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace TargetSystemBakeVisibilityCommandlet
+{
+	static bool SavePackage(UPackage* Package, UObject* Asset, const FString& Extension)
+	{
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), Extension);
+		if (!UPackage::SavePackage(Package, Asset, *Filename, SaveArgs))
+		{
+			TS_LOG(Error, TEXT("UTargetSystemBakeVisibilityCommandlet - Failed to save %s"), *Filename);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+UTargetSystemBakeVisibilityCommandlet::UTargetSystemBakeVisibilityCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTargetSystemBakeVisibilityCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		TS_LOG(Error, TEXT("UTargetSystemBakeVisibilityCommandlet - Missing -Map=/Game/Path/To/Map"));
+		return 1;
+	}
+
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		TS_LOG(Error, TEXT("UTargetSystemBakeVisibilityCommandlet - Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	// Only static geometry collision is needed, nothing gets ticked nor simulated
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true));
+	}
+	World->UpdateWorldComponents(true, false);
+
+	int32 NumVolumes = 0;
+	bool bMapDirty = false;
+	bool bSucceeded = true;
+	for (TActorIterator<ATargetSystemVisibilityVolume> It(World); It; ++It)
+	{
+		ATargetSystemVisibilityVolume* Volume = *It;
+		if (!Volume->VisibilityData)
+		{
+			const FString AssetPackageName = MapPackage->GetName() + TEXT("_") + Volume->GetName();
+			UPackage* AssetPackage = CreatePackage(*AssetPackageName);
+			Volume->Modify();
+			Volume->VisibilityData = NewObject<UTargetSystemVisibilityData>(AssetPackage, *FPackageName::GetShortName(AssetPackageName), RF_Public | RF_Standalone);
+			bMapDirty = true;
+		}
+
+		bSucceeded &= FTargetSystemVisibilityBaker::Bake(*Volume);
+		bSucceeded &= TargetSystemBakeVisibilityCommandlet::SavePackage(Volume->VisibilityData->GetPackage(), Volume->VisibilityData, FPackageName::GetAssetPackageExtension());
+		++NumVolumes;
+	}
+
+	if (bMapDirty)
+	{
+		bSucceeded &= TargetSystemBakeVisibilityCommandlet::SavePackage(MapPackage, World, FPackageName::GetMapPackageExtension());
+	}
+
+	TS_LOG(Display, TEXT("UTargetSystemBakeVisibilityCommandlet - Baked %d volumes of %s"), NumVolumes, *MapName);
+
+	World->CleanupWorld();
+	World->RemoveFromRoot();
+	return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemEditor.h"
+
+#define LOCTEXT_NAMESPACE "FTargetSystemEditorModule"
+
+void FTargetSystemEditorModule::StartupModule()
+{
+}
+
+void FTargetSystemEditorModule::ShutdownModule()
+{
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FTargetSystemEditorModule, TargetSystemEditor)
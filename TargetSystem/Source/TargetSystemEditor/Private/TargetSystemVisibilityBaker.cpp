@@ -0,0 +1,135 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#include "TargetSystemVisibilityBaker.h"
+#include "CollisionQueryParams.h"
+#include "EngineUtils.h"
+#include "TargetSystemLog.h"
+#include "TargetSystemVisibilityData.h"
+#include "TargetSystemVisibilityVolume.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TargetSystemVisibilityBaker
+{
+	static void BakeWorld(UWorld* World)
+	{
+		int32 NumVolumes = 0;
+		for (TActorIterator<ATargetSystemVisibilityVolume> It(World); It; ++It)
+		{
+			NumVolumes += FTargetSystemVisibilityBaker::Bake(**It) ? 1 : 0;
+		}
+
+		TS_LOG(Display, TEXT("TargetSystem.BakeVisibility - Baked %d volumes, save their VisibilityData assets to keep them"), NumVolumes);
+	}
+}
+
+static FAutoConsoleCommandWithWorld TargetSystemBakeVisibilityCommand(
+	TEXT("TargetSystem.BakeVisibility"),
+	TEXT("Bakes the static visibility of every Target System Visibility Volume of the world into their VisibilityData asset."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&TargetSystemVisibilityBaker::BakeWorld)
+);
+
+bool FTargetSystemVisibilityBaker::Bake(ATargetSystemVisibilityVolume& Volume)
+{
+	if (!Volume.VisibilityData)
+	{
+		TS_LOG(Error, TEXT("FTargetSystemVisibilityBaker::Bake - %s: No VisibilityData asset to bake into"), *Volume.GetName());
+		return false;
+	}
+
+	return Bake(*Volume.VisibilityData, Volume.GetWorld(), Volume.GetBounds().GetBox(), Volume.CellSize, Volume.MaxDistance, Volume.TraceChannel);
+}
+
+bool FTargetSystemVisibilityBaker::Bake(UTargetSystemVisibilityData& Data, UWorld* World, const FBox& Bounds, const float CellSize, const float MaxDistance, const ECollisionChannel TraceChannel)
+{
+	check(World);
+
+	Data.Modify();
+	Data.Origin = Bounds.Min;
+	Data.CellSize = FMath::Max(CellSize, 1.0f);
+	Data.TraceChannel = TraceChannel;
+
+	const FVector Size = Bounds.GetSize();
+	const FIntVector Dimensions(
+		FMath::Max(FMath::CeilToInt(Size.X / Data.CellSize), 1),
+		FMath::Max(FMath::CeilToInt(Size.Y / Data.CellSize), 1),
+		FMath::Max(FMath::CeilToInt(Size.Z / Data.CellSize), 1)
+	);
+	Data.Dimensions = Dimensions;
+
+	const int32 Radius = FMath::CeilToInt(MaxDistance / Data.CellSize);
+	const FIntVector CellRadius(FMath::Min(Radius, Dimensions.X - 1), FMath::Min(Radius, Dimensions.Y - 1), FMath::Min(Radius, Dimensions.Z - 1));
+	Data.CellRadius = CellRadius;
+
+	const int32 NumCells = Dimensions.X * Dimensions.Y * Dimensions.Z;
+	const int32 NumStoredOffsets = Data.GetNumOffsets() / 2;
+	const int64 NumPairs = static_cast<int64>(NumCells) * NumStoredOffsets;
+	if (NumPairs > MAX_int32)
+	{
+		TS_LOG(Error, TEXT("FTargetSystemVisibilityBaker::Bake - %s: %lld pairs of cells, increase the cell size or reduce the bounds"), *Data.GetName(), NumPairs);
+		Data.ClearPairBits.Reset();
+		return false;
+	}
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(TargetSystemBakeVisibility), false);
+	Params.MobilityType = EQueryMobilityType::Static;
+
+	// Any point of a cell is within the box at its center, so the box swept between two cells centers covers every
+	// segment between them. Initial overlaps count as hits, for geometry within either cell to be accounted for.
+	const FCollisionShape CellShape = FCollisionShape::MakeBox(FVector(Data.CellSize * 0.5f));
+
+	const FVector Origin = Data.Origin;
+	const float CellSizeValue = Data.CellSize;
+	const float MaxDistanceSquared = FMath::Square(MaxDistance);
+	const FIntVector OffsetsSize = CellRadius * 2 + FIntVector(1);
+
+	// One byte per pair while sweeping in parallel, cells sharing packed words. Laid out as UTargetSystemVisibilityData
+	// looks pairs up: the offsets after the zero one, in linear order, for each cell.
+	TArray<uint8> ClearPairs;
+	ClearPairs.SetNumZeroed(NumPairs);
+
+	ParallelFor(NumCells, [&](const int32 CellIndex)
+	{
+		const FIntVector Cell(CellIndex % Dimensions.X, (CellIndex / Dimensions.X) % Dimensions.Y, CellIndex / (Dimensions.X * Dimensions.Y));
+		const FVector CellCenter = Origin + (FVector(Cell) + 0.5f) * CellSizeValue;
+
+		for (int32 StoredOffset = 0; StoredOffset < NumStoredOffsets; ++StoredOffset)
+		{
+			const int32 OffsetIndex = NumStoredOffsets + 1 + StoredOffset;
+			const FIntVector Offset(
+				OffsetIndex % OffsetsSize.X - CellRadius.X,
+				(OffsetIndex / OffsetsSize.X) % OffsetsSize.Y - CellRadius.Y,
+				OffsetIndex / (OffsetsSize.X * OffsetsSize.Y) - CellRadius.Z
+			);
+
+			const FIntVector OtherCell = Cell + Offset;
+			const FVector Delta = FVector(Offset) * CellSizeValue;
+			if (OtherCell.X < 0 || OtherCell.Y < 0 || OtherCell.Z < 0 || OtherCell.X >= Dimensions.X || OtherCell.Y >= Dimensions.Y || OtherCell.Z >= Dimensions.Z
+				|| Delta.SizeSquared() > MaxDistanceSquared)
+			{
+				continue;
+			}
+
+			ClearPairs[CellIndex * NumStoredOffsets + StoredOffset] = !World->SweepTestByChannel(CellCenter, CellCenter + Delta, FQuat::Identity, TraceChannel, CellShape, Params);
+		}
+	});
+
+	Data.ClearPairBits.Init(0, FMath::DivideAndRoundUp(static_cast<int32>(NumPairs), UTargetSystemVisibilityData::PairsPerWord));
+
+	int32 NumClearPairs = 0;
+	for (int32 PairIndex = 0; PairIndex < ClearPairs.Num(); ++PairIndex)
+	{
+		if (ClearPairs[PairIndex])
+		{
+			Data.ClearPairBits[PairIndex / UTargetSystemVisibilityData::PairsPerWord] |= 1u << (PairIndex % UTargetSystemVisibilityData::PairsPerWord);
+			++NumClearPairs;
+		}
+	}
+
+	Data.MarkPackageDirty();
+
+	TS_LOG(Display, TEXT("FTargetSystemVisibilityBaker::Bake - %s: %d cells, %d clear pairs out of %d, %d KB"),
+		*Data.GetName(), NumCells, NumClearPairs, ClearPairs.Num(), static_cast<int32>(Data.ClearPairBits.GetAllocatedSize() / 1024));
+	return true;
+}
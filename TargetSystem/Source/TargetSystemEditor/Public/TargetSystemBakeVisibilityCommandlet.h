@@ -0,0 +1,27 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TargetSystemBakeVisibilityCommandlet.generated.h"
+
+/**
+ * Bakes the static visibility of every Target System Visibility Volume of a level, and saves the baked assets.
+ *
+ * Usage: UnrealEditor-Cmd.exe <Project> -run=TargetSystemBakeVisibility -Map=/Game/Maps/MyMap
+ *
+ * Volumes without a VisibilityData asset get one created next to the level, in which case the level is saved as well.
+ * Only the actors loaded with the level are baked, volumes of unloaded World Partition cells are not.
+ */
+UCLASS()
+class TARGETSYSTEMEDITOR_API UTargetSystemBakeVisibilityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTargetSystemBakeVisibilityCommandlet();
+
+	//~ UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
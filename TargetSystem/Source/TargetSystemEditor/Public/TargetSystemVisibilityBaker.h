@@ -0,0 +1,31 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class ATargetSystemVisibilityVolume;
+class UTargetSystemVisibilityData;
+
+/**
+ * Bakes the cell to cell static visibility of Target System Visibility Volumes into their VisibilityData asset.
+ *
+ * In editor, the TargetSystem.BakeVisibility console command bakes every volume of the edited level. The
+ * TargetSystemBakeVisibility commandlet bakes and saves the ones of a map.
+ */
+class TARGETSYSTEMEDITOR_API FTargetSystemVisibilityBaker
+{
+public:
+	// Bakes Volume into its VisibilityData asset. Returns false when the volume has no asset to bake into.
+	static bool Bake(ATargetSystemVisibilityVolume& Volume);
+
+	/**
+	 * Bakes the static visibility of Bounds in World into Data, replacing any previous data.
+	 *
+	 * @param CellSize Size of the cells
+	 * @param MaxDistance Distance up to which the visibility between two cells is baked, the targeting range
+	 * @param TraceChannel Channel line of sight checks trace on
+	 */
+	static bool Bake(UTargetSystemVisibilityData& Data, UWorld* World, const FBox& Bounds, float CellSize, float MaxDistance, ECollisionChannel TraceChannel);
+};
@@ -0,0 +1,41 @@
+// Copyright 2018-2021 Mickael Daniel. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.IO;
+
+public class TargetSystemEditor : ModuleRules
+{
+	public TargetSystemEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicIncludePaths.AddRange(
+			new string[] {
+				Path.Combine(ModuleDirectory, "Public")
+			}
+			);
+
+		PrivateIncludePaths.AddRange(
+			new string[] {
+				Path.Combine(ModuleDirectory, "Private")
+			}
+			);
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine"
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"TargetSystem",
+				"UnrealEd"
+			}
+			);
+	}
+}